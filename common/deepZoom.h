@@ -0,0 +1,263 @@
+#ifndef _DEEP_ZOOM_H_
+#define _DEEP_ZOOM_H_
+
+#include <stdlib.h>
+#include <ctype.h>
+#include <vector>
+
+//
+// Deep-zoom support shared by the Mandelbrot programs.
+//
+// A float viewport stops resolving individual pixels below a scale of
+// about 1e-5, and double below about 1e-13.  Deeper views are rendered
+// by perturbation: a single reference orbit Z_n of the view center is
+// computed in double-double precision (about 32 significant digits),
+// and every pixel c = C + dc iterates only its small difference from
+// that orbit,
+//
+//     z_n = Z_n + d_n,    d_{n+1} = (2 Z_n + d_n) d_n + dc,
+//
+// which double represents accurately at any scale down to ~1e-300.
+//
+// Glitches, where the pixel orbit stops following the reference, are
+// detected with the test |z_n| < |d_n| (the pixel orbit is closer to
+// zero than to the reference).  Such a pixel is rebased: d becomes z
+// and the reference index restarts at Z_0 = 0, which is exact because
+// the reference orbit starts from zero.  The same rebase is done when
+// the pixel outlives the reference orbit, so no second reference is
+// ever needed.
+//
+// All arithmetic below must be compiled without FMA contraction: the
+// double-double routines rely on exact rounding of every operation,
+// and the scalar and SIMD kernels are expected to agree bit for bit.
+
+//
+// DoubleDouble --
+//
+// An unevaluated sum hi + lo with |lo| <= ulp(hi) / 2.
+struct DoubleDouble {
+    double hi, lo;
+};
+
+static inline DoubleDouble ddFromDouble(double a)
+{
+    DoubleDouble r = { a, 0.0 };
+    return r;
+}
+
+static inline DoubleDouble ddQuickTwoSum(double a, double b)
+{
+    DoubleDouble r;
+    r.hi = a + b;
+    r.lo = b - (r.hi - a);
+    return r;
+}
+
+static inline DoubleDouble ddTwoSum(double a, double b)
+{
+    DoubleDouble r;
+    r.hi = a + b;
+    double bb = r.hi - a;
+    r.lo = (a - (r.hi - bb)) + (b - bb);
+    return r;
+}
+
+// Dekker's product: a * b exactly, without relying on FMA.
+static inline DoubleDouble ddTwoProd(double a, double b)
+{
+    const double SPLITTER = 134217729.0;    // 2^27 + 1
+    double t = SPLITTER * a;
+    double ahi = t - (t - a), alo = a - ahi;
+    t = SPLITTER * b;
+    double bhi = t - (t - b), blo = b - bhi;
+
+    DoubleDouble r;
+    r.hi = a * b;
+    r.lo = ((ahi * bhi - r.hi) + ahi * blo + alo * bhi) + alo * blo;
+    return r;
+}
+
+static inline DoubleDouble ddAdd(DoubleDouble a, DoubleDouble b)
+{
+    DoubleDouble s = ddTwoSum(a.hi, b.hi);
+    return ddQuickTwoSum(s.hi, s.lo + (a.lo + b.lo));
+}
+
+static inline DoubleDouble ddNeg(DoubleDouble a)
+{
+    DoubleDouble r = { -a.hi, -a.lo };
+    return r;
+}
+
+static inline DoubleDouble ddSub(DoubleDouble a, DoubleDouble b)
+{
+    return ddAdd(a, ddNeg(b));
+}
+
+static inline DoubleDouble ddMul(DoubleDouble a, DoubleDouble b)
+{
+    DoubleDouble p = ddTwoProd(a.hi, b.hi);
+    return ddQuickTwoSum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+}
+
+static inline DoubleDouble ddMulDouble(DoubleDouble a, double b)
+{
+    DoubleDouble p = ddTwoProd(a.hi, b);
+    return ddQuickTwoSum(p.hi, p.lo + a.lo * b);
+}
+
+static inline DoubleDouble ddDiv(DoubleDouble a, DoubleDouble b)
+{
+    double q1 = a.hi / b.hi;
+    DoubleDouble r = ddSub(a, ddMulDouble(b, q1));
+    double q2 = r.hi / b.hi;
+    r = ddSub(r, ddMulDouble(b, q2));
+    double q3 = r.hi / b.hi;
+    DoubleDouble q = ddQuickTwoSum(q1, q2);
+    return ddAdd(q, ddFromDouble(q3));
+}
+
+//
+// ddParse --
+//
+// Parse a decimal number such as "-0.743643887037158704752191506114774"
+// or "1.5e-3" to full double-double precision.  Returns a pointer to the
+// first character after the number, or NULL if there is no number.
+static inline const char* ddParse(const char* s, DoubleDouble* value)
+{
+    bool negative = false;
+    if (*s == '+' || *s == '-')
+        negative = *s++ == '-';
+
+    DoubleDouble mantissa = ddFromDouble(0.0);
+    int exponent = 0;
+    bool anyDigits = false;
+    for (; isdigit((unsigned char)*s); s++, anyDigits = true)
+        mantissa = ddAdd(ddMulDouble(mantissa, 10.0), ddFromDouble(*s - '0'));
+    if (*s == '.') {
+        for (s++; isdigit((unsigned char)*s); s++, anyDigits = true, exponent--)
+            mantissa = ddAdd(ddMulDouble(mantissa, 10.0), ddFromDouble(*s - '0'));
+    }
+    if (!anyDigits)
+        return NULL;
+    if (*s == 'e' || *s == 'E') {
+        char* end;
+        long e = strtol(s + 1, &end, 10);
+        if (end != s + 1) {
+            exponent += (int)e;
+            s = end;
+        }
+    }
+
+    // Powers of ten up to 10^45 are exact in double-double, so scale by
+    // one exact power rather than by repeated roundings.
+    while (exponent != 0) {
+        int step = exponent > 0 ? (exponent > 45 ? 45 : exponent)
+                                : (exponent < -45 ? 45 : -exponent);
+        DoubleDouble power = ddFromDouble(1.0);
+        for (int k = 0; k < step; k++)
+            power = ddMulDouble(power, 10.0);
+        if (exponent > 0) {
+            mantissa = ddMul(mantissa, power);
+            exponent -= step;
+        } else {
+            mantissa = ddDiv(mantissa, power);
+            exponent += step;
+        }
+    }
+
+    *value = negative ? ddNeg(mantissa) : mantissa;
+    return s;
+}
+
+//
+// DeepFrame --
+//
+// Everything a kernel needs to render one deep-zoom frame.  Pixel (i, j)
+// has c = C + dc with dc = (deltaX0 + i * pixelSize, deltaY0 + j * pixelSize),
+// where C is the view center and the reference point, matching the
+// x0 + i * dx mapping of the float kernels.
+struct DeepFrame {
+    int width, height;
+    double pixelSize;
+    double deltaX0, deltaY0;
+    int refLength;                  // index of the last reference point
+    std::vector<double> refRe;      // Z_0 .. Z_refLength rounded to double
+    std::vector<double> refIm;
+};
+
+//
+// prepareDeepFrame --
+//
+// Compute the reference orbit of (centerX, centerY) in double-double
+// for a view scale units high.  The orbit stops after maxIterations
+// steps or once the reference escapes.
+static inline void prepareDeepFrame(DoubleDouble centerX, DoubleDouble centerY, double scale,
+                                    int width, int height, int maxIterations, DeepFrame* frame)
+{
+    frame->width = width;
+    frame->height = height;
+    frame->pixelSize = scale / height;
+    frame->deltaX0 = -0.5 * width * frame->pixelSize;
+    frame->deltaY0 = -0.5 * height * frame->pixelSize;
+
+    frame->refRe.assign(1, 0.0);
+    frame->refIm.assign(1, 0.0);
+
+    DoubleDouble z_re = ddFromDouble(0.0), z_im = ddFromDouble(0.0);
+    for (int n = 0; n < maxIterations; n++) {
+        DoubleDouble re2 = ddMul(z_re, z_re);
+        DoubleDouble im2 = ddMul(z_im, z_im);
+        DoubleDouble new_im = ddAdd(ddMulDouble(ddMul(z_re, z_im), 2.0), centerY);
+        z_re = ddAdd(ddSub(re2, im2), centerX);
+        z_im = new_im;
+
+        frame->refRe.push_back(z_re.hi);
+        frame->refIm.push_back(z_im.hi);
+        if (z_re.hi * z_re.hi + z_im.hi * z_im.hi > 4.0)
+            break;
+    }
+    frame->refLength = (int)frame->refRe.size() - 1;
+}
+
+//
+// deepPixel --
+//
+// Iteration count of the pixel at offset (dc_re, dc_im) from the
+// reference, with the same meaning as mandel(): the index of the first
+// step whose result has |z|^2 > 4, or count if there is none.
+static inline int deepPixel(const DeepFrame& frame, double dc_re, double dc_im, int count)
+{
+    const double* ref_re = frame.refRe.data();
+    const double* ref_im = frame.refIm.data();
+
+    double d_re = 0.0, d_im = 0.0;
+    int m = 0;
+    int i;
+    for (i = 0; i < count; ++i) {
+        double t_re = 2.0 * ref_re[m] + d_re;
+        double t_im = 2.0 * ref_im[m] + d_im;
+        double new_re = t_re * d_re - t_im * d_im + dc_re;
+        double new_im = t_re * d_im + t_im * d_re + dc_im;
+        d_re = new_re;
+        d_im = new_im;
+        m++;
+
+        double z_re = ref_re[m] + d_re;
+        double z_im = ref_im[m] + d_im;
+        double z2 = z_re * z_re + z_im * z_im;
+        if (z2 > 4.0)
+            break;
+
+        // glitch or end of the reference orbit: rebase onto Z_0 = 0
+        if (z2 < d_re * d_re + d_im * d_im || m == frame.refLength) {
+            d_re = z_re;
+            d_im = z_im;
+            m = 0;
+        }
+    }
+
+    return i;
+}
+
+#endif // _DEEP_ZOOM_H_
@@ -0,0 +1,121 @@
+#ifndef _ISPC_TARGET_H_
+#define _ISPC_TARGET_H_
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+
+//
+// ISPC target selection --
+//
+// The default build compiles every .ispc file for several targets (see
+// ISPC_TARGETS in the Makefiles) into one object, and ISPC's dispatch
+// code runs the best one the CPU supports, checked by CPUID on the
+// first call.  A single binary therefore runs on SSE4-only machines and
+// still uses AVX-512 where it is available.
+//
+// To benchmark each target on the same host, `make targets` also links
+// one binary per target, <app>-<target>, whose main is compiled with
+// ISPC_FORCED_TARGET set to that target's name, and forceIspcTarget()
+// re-runs the program as that binary.  avx2-i32x16 exists only as such
+// a forced build: ISPC allows one target per ISA in a multi-target
+// object, and the dispatcher uses avx2-i32x8 for AVX2.
+
+static const char* const ISPC_TARGETS[] = {
+    "sse4-i32x4", "avx2-i32x8", "avx2-i32x16", "avx512skx-i32x16"
+};
+static const int NUM_ISPC_TARGETS = sizeof(ISPC_TARGETS) / sizeof(ISPC_TARGETS[0]);
+
+// Whether the CPU can execute code compiled for target.
+static inline bool ispcTargetSupported(const char* target)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (strncmp(target, "sse4-", 5) == 0)
+        return __builtin_cpu_supports("sse4.2");
+    if (strncmp(target, "avx2-", 5) == 0)
+        return __builtin_cpu_supports("avx2");
+    if (strncmp(target, "avx512skx-", 10) == 0)
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd") &&
+               __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512bw") &&
+               __builtin_cpu_supports("avx512vl");
+#endif
+    return false;
+}
+
+//
+// activeIspcTarget --
+//
+// The target whose code runs in this process: the one this binary was
+// built for, or else the one ISPC's dispatcher picks in the
+// multi-target build.
+static inline const char* activeIspcTarget()
+{
+#ifdef ISPC_FORCED_TARGET
+    return ISPC_FORCED_TARGET;
+#else
+    if (ispcTargetSupported("avx512skx-i32x16"))
+        return "avx512skx-i32x16";
+    if (ispcTargetSupported("avx2-i32x8"))
+        return "avx2-i32x8";
+    if (ispcTargetSupported("sse4-i32x4"))
+        return "sse4-i32x4";
+    return "none (CPU lacks SSE4.2)";
+#endif
+}
+
+//
+// forceIspcTarget --
+//
+// Re-run the program as the binary built for target, with the same
+// arguments.  Returns 0 if this process already is that binary and
+// should carry on; otherwise only returns, with status 1, on error.
+static inline int forceIspcTarget(const char* target, char* argv[])
+{
+#ifdef ISPC_FORCED_TARGET
+    if (strcmp(ISPC_FORCED_TARGET, target) == 0)
+        return 0;
+#endif
+
+    bool known = false;
+    for (int i = 0; i < NUM_ISPC_TARGETS; i++)
+        known = known || strcmp(ISPC_TARGETS[i], target) == 0;
+    if (!known) {
+        fprintf(stderr, "Unknown ISPC target %s; choose one of", target);
+        for (int i = 0; i < NUM_ISPC_TARGETS; i++)
+            fprintf(stderr, " %s", ISPC_TARGETS[i]);
+        fprintf(stderr, "\n");
+        return 1;
+    }
+    if (!ispcTargetSupported(target)) {
+        fprintf(stderr, "This CPU cannot run ISPC target %s\n", target);
+        return 1;
+    }
+
+    // The forced binaries sit next to this one.  argv[0] has no
+    // directory when the program was found through PATH, so prefer the
+    // executable's own path, and fall back to a PATH search.
+    char self[4096];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    std::string path = length > 0 ? std::string(self, length) : std::string(argv[0]);
+#ifdef ISPC_FORCED_TARGET
+    // this is <app>-<ISPC_FORCED_TARGET>; its siblings are <app>-<target>
+    std::string suffix = std::string("-") + ISPC_FORCED_TARGET;
+    if (path.size() > suffix.size() &&
+        path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0)
+        path.erase(path.size() - suffix.size());
+#endif
+    path += std::string("-") + target;
+    if (length > 0)
+        execv(path.c_str(), argv);
+    else
+        execvp(path.c_str(), argv);
+    fprintf(stderr, "Cannot run %s (build it with 'make targets'): %s\n",
+            path.c_str(), strerror(errno));
+    return 1;
+}
+
+#endif // _ISPC_TARGET_H_
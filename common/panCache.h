@@ -0,0 +1,167 @@
+#ifndef _PAN_CACHE_H_
+#define _PAN_CACHE_H_
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+//
+// Frame-to-frame result cache for panning --
+//
+// The cache keeps the last rendered frame together with the viewport it
+// was rendered for.  When the next viewport is the same one translated
+// by a whole number of pixels, the old frame is shifted in place and
+// only the newly exposed strips have to be computed.
+//
+// Shifted pixels only equal a fresh render if every frame maps pixels
+// to the complex plane the same way, so all frames are placed on the
+// pixel grid of an anchor viewport (the first frame, or the last one
+// that was not a pure translation): pixel (i, j) of the current frame
+// is pixel (colOffset + i, rowOffset + j) of the anchor, at
+//
+//     x = anchorX0 + (colOffset + i) * dx,  y = anchorY0 + (rowOffset + j) * dy,
+//
+// with dx and dy the anchor's float pixel sizes.  Renderers for the
+// exposed strips must use exactly this mapping.
+
+// A rectangle of pixels in frame coordinates.
+struct PanRect {
+    int x, y;
+    int width, height;
+};
+
+class PanCache {
+public:
+    // A translation is accepted if it is within this many pixels of a
+    // whole number of pixels.
+    static constexpr double PIXEL_TOLERANCE = 1e-3;
+
+    PanCache() : valid_(false), width_(0), height_(0), colOffset_(0), rowOffset_(0) {}
+
+    //
+    // update --
+    //
+    // Prepare the frame for viewport (x0, y0, x1, y1) at width x height.
+    // Returns the number of rectangles (at most 2) written to rects that
+    // must now be rendered into frame(); everything else already holds
+    // the right values.
+    int update(float x0, float y0, float x1, float y1, int width, int height, PanRect rects[2])
+    {
+        int shiftX, shiftY;
+        if (!translation(x0, y0, x1, y1, width, height, &shiftX, &shiftY)) {
+            valid_ = true;
+            x0_ = x0;
+            y0_ = y0;
+            x1_ = x1;
+            y1_ = y1;
+            width_ = width;
+            height_ = height;
+            colOffset_ = rowOffset_ = 0;
+            frame_.resize((size_t)width * height);
+            rects[0].x = rects[0].y = 0;
+            rects[0].width = width;
+            rects[0].height = height;
+            return 1;
+        }
+
+        colOffset_ += shiftX;
+        rowOffset_ += shiftY;
+        if (abs(shiftX) >= width || abs(shiftY) >= height) {
+            rects[0].x = rects[0].y = 0;
+            rects[0].width = width;
+            rects[0].height = height;
+            return 1;
+        }
+
+        shiftFrame(shiftX, shiftY);
+
+        // rows that scrolled in, then the columns that scrolled in on
+        // the remaining rows
+        int numRects = 0;
+        int keptY = shiftY > 0 ? 0 : -shiftY;
+        int keptHeight = height - abs(shiftY);
+        if (shiftY != 0) {
+            PanRect& r = rects[numRects++];
+            r.x = 0;
+            r.y = shiftY > 0 ? keptHeight : 0;
+            r.width = width;
+            r.height = abs(shiftY);
+        }
+        if (shiftX != 0) {
+            PanRect& r = rects[numRects++];
+            r.x = shiftX > 0 ? width - shiftX : 0;
+            r.y = keptY;
+            r.width = abs(shiftX);
+            r.height = keptHeight;
+        }
+        return numRects;
+    }
+
+    // Forget the cached frame; the next update renders everything.
+    void invalidate() { valid_ = false; }
+
+    int* frame() { return frame_.data(); }
+
+    // The anchor viewport and the current frame's offset on its grid.
+    float anchorX0() const { return x0_; }
+    float anchorY0() const { return y0_; }
+    float anchorX1() const { return x1_; }
+    float anchorY1() const { return y1_; }
+    int colOffset() const { return colOffset_; }
+    int rowOffset() const { return rowOffset_; }
+
+private:
+    // Whether the viewport is the current one moved by a whole number of
+    // pixels, and by how many.
+    bool translation(float x0, float y0, float x1, float y1, int width, int height,
+                     int* shiftX, int* shiftY) const
+    {
+        if (!valid_ || width != width_ || height != height_)
+            return false;
+
+        double dx = (double)(x1_ - x0_) / width_;
+        double dy = (double)(y1_ - y0_) / height_;
+        if (fabs((double)(x1 - x0) - (x1_ - x0_)) > PIXEL_TOLERANCE * fabs(dx) ||
+            fabs((double)(y1 - y0) - (y1_ - y0_)) > PIXEL_TOLERANCE * fabs(dy))
+            return false;
+
+        double sx = (x0 - x0_) / dx - colOffset_;
+        double sy = (y0 - y0_) / dy - rowOffset_;
+        double rx = floor(sx + 0.5), ry = floor(sy + 0.5);
+        if (fabs(sx - rx) > PIXEL_TOLERANCE || fabs(sy - ry) > PIXEL_TOLERANCE ||
+            fabs(rx) > 1e8 || fabs(ry) > 1e8)
+            return false;
+
+        *shiftX = (int)rx;
+        *shiftY = (int)ry;
+        return true;
+    }
+
+    // Move pixel (i + shiftX, j + shiftY) to (i, j) where both are inside
+    // the frame.
+    void shiftFrame(int shiftX, int shiftY)
+    {
+        int rowLength = width_ - abs(shiftX);
+        int dstX = shiftX > 0 ? 0 : -shiftX;
+        int srcX = shiftX > 0 ? shiftX : 0;
+        int numRows = height_ - abs(shiftY);
+
+        for (int r = 0; r < numRows; r++) {
+            // walk rows in the direction that never overwrites a row
+            // that is still to be read
+            int j = shiftY >= 0 ? r : height_ - 1 - r;
+            int* dst = frame_.data() + (size_t)j * width_;
+            const int* src = frame_.data() + (size_t)(j + shiftY) * width_;
+            memmove(dst + dstX, src + srcX, rowLength * sizeof(int));
+        }
+    }
+
+    bool valid_;
+    float x0_, y0_, x1_, y1_;
+    int width_, height_;
+    int colOffset_, rowOffset_;
+    std::vector<int> frame_;
+};
+
+#endif // _PAN_CACHE_H_
@@ -2,11 +2,225 @@
 #include <stdio.h>
 #include <math.h>
 #include <algorithm>
+#include <thread>
+#include <vector>
 
+#include "CycleTimer.h"
+#include "tileLayout.h"
 
 
+
+//
+// PPM encoding --
+//
+// Every iteration count maps to one gray level, so the mapping is done
+// through a table of maxIterations + 1 entries computed once per
+// maxIterations instead of a pow() per pixel.  Rows are converted to
+// RGB (PPM) or gray (PGM) bytes by several threads into one buffer,
+// which is written with a single fwrite; large images go through in
+// blocks of PPM_BLOCK_PIXELS to bound the buffer size.
+
+static const size_t PPM_BLOCK_PIXELS = (size_t)1 << 22;
+
+// Below this many pixels a block is converted on the calling thread.
+static const size_t PPM_PARALLEL_PIXELS = (size_t)1 << 16;
+
+// Threads the image encoders may use; 0 means one per hardware thread.
+static int encodeThreads = 0;
+
+void setImageEncodeThreads(int numThreads)
+{
+    encodeThreads = numThreads;
+}
+
+int imageEncodeThreads()
+{
+    if (encodeThreads > 0)
+        return encodeThreads;
+    return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+//
+// ppmTable --
+//
+// Gray level of iteration counts 0 .. maxIterations.  Counts are
+// clamped to maxIterations, scaled by 1/256 and raised to a power (<1)
+// to increase brightness of low iteration count pixels, a.k.a. make
+// things look cooler.  The float math and the conversion to 8 bits are
+// those of the original per-pixel code, so images are unchanged.
+static const unsigned char* ppmTable(int maxIterations)
+{
+    static thread_local std::vector<unsigned char> table;
+    static thread_local int tableIterations = -1;
+
+    if (tableIterations != maxIterations) {
+        table.resize(maxIterations + 1);
+        for (int k = 0; k <= maxIterations; ++k) {
+            float mapped = pow(static_cast<float>(k) / 256.f, .5f);
+            table[k] = static_cast<unsigned char>(static_cast<int>(255.f * mapped));
+        }
+        tableIterations = maxIterations;
+    }
+    return table.data();
+}
+
+//
+// Histogram equalization --
+//
+// With many iterations the fixed curve of ppmTable leaves deep zooms
+// almost uniformly gray, since their counts span a narrow band far
+// above 256.  In equalized mode the gray level of count k is instead
+// the fraction of escaped pixels with count <= k, so the levels are
+// spread evenly over the pixels actually in the image.  Pixels that
+// never escaped (count >= maxIterations) stay white, as they are with
+// the default curve at 256 iterations.
+//
+// The histogram is counted by the encoder threads into private
+// histograms over disjoint pixel ranges, which are then summed.
+
+static bool equalizeColors = false;
+
+void setPPMEqualize(bool equalize)
+{
+    equalizeColors = equalize;
+}
+
+static void countIterations(const int* data, size_t numPixels, unsigned int maxIterations,
+                            size_t* histogram)
+{
+    for (size_t i = 0; i < numPixels; ++i)
+        histogram[std::min(static_cast<unsigned int>(data[i]), maxIterations)]++;
+}
+
+//
+// equalizedTable --
+//
+// Gray level of iteration counts 0 .. maxIterations for the image in
+// data, stored in table.
+static const unsigned char* equalizedTable(const int* data, size_t numPixels, int maxIterations,
+                                           std::vector<unsigned char>& table)
+{
+    double startTime = CycleTimer::currentSeconds();
+    size_t numBins = (size_t)maxIterations + 1;
+    int numThreads = imageEncodeThreads();
+    if (numPixels < PPM_PARALLEL_PIXELS)
+        numThreads = 1;
+
+    std::vector<size_t> histograms(numThreads * numBins, 0);
+    size_t perThread = (numPixels + numThreads - 1) / numThreads;
+    std::vector<std::thread> workers;
+    for (int t = 1; t < numThreads; ++t) {
+        size_t begin = std::min(numPixels, t * perThread);
+        size_t end = std::min(numPixels, begin + perThread);
+        workers.push_back(std::thread(countIterations, data + begin, end - begin,
+                                      (unsigned int)maxIterations, &histograms[t * numBins]));
+    }
+    countIterations(data, std::min(numPixels, perThread), maxIterations, &histograms[0]);
+    for (std::thread& w : workers)
+        w.join();
+
+    size_t* histogram = &histograms[0];
+    for (int t = 1; t < numThreads; ++t)
+        for (size_t k = 0; k < numBins; ++k)
+            histogram[k] += histograms[t * numBins + k];
+
+    size_t numEscaped = numPixels - histogram[maxIterations];
+    table.resize(numBins);
+    size_t cumulative = 0;
+    for (int k = 0; k < maxIterations; ++k) {
+        cumulative += histogram[k];
+        table[k] = static_cast<unsigned char>(255.0 * cumulative / std::max(numEscaped, (size_t)1));
+    }
+    table[maxIterations] = 255;
+
+    double endTime = CycleTimer::currentSeconds();
+    printf("[histogram equalize]:\t\t[%.3f] ms\n", (endTime - startTime) * 1000);
+    return table.data();
+}
+
+// Table for a whole image in the current color mode.
+static const unsigned char* imageTable(const int* data, size_t numPixels, int maxIterations,
+                                       std::vector<unsigned char>& table)
+{
+    if (equalizeColors)
+        return equalizedTable(data, numPixels, maxIterations, table);
+    return ppmTable(maxIterations);
+}
+
+// channels copies of each pixel's gray level: 3 for PPM, 1 for PGM.
+template <int channels>
+static void mapPPMPixels(const unsigned char* table, unsigned int maxIterations,
+                         const int* data, size_t numPixels, unsigned char* out)
+{
+    for (size_t i = 0; i < numPixels; ++i) {
+        unsigned int k = std::min(static_cast<unsigned int>(data[i]), maxIterations);
+        unsigned char gray = table[k];
+        for (int c = 0; c < channels; ++c)
+            out[channels * i + c] = gray;
+    }
+}
+
+// Convert numPixels counts to bytes in out, split over the encoder threads.
+template <int channels>
+static void convertPPMPixels(const unsigned char* table, const int* data, size_t numPixels,
+                             int maxIterations, unsigned char* out)
+{
+    int numThreads = imageEncodeThreads();
+    if (numPixels < PPM_PARALLEL_PIXELS || numThreads == 1) {
+        mapPPMPixels<channels>(table, maxIterations, data, numPixels, out);
+        return;
+    }
+
+    size_t perThread = (numPixels + numThreads - 1) / numThreads;
+    std::vector<std::thread> workers;
+    for (int t = 1; t < numThreads; ++t) {
+        size_t begin = std::min(numPixels, t * perThread);
+        size_t end = std::min(numPixels, begin + perThread);
+        workers.push_back(std::thread(mapPPMPixels<channels>, table, (unsigned int)maxIterations,
+                                      data + begin, end - begin, out + channels * begin));
+    }
+    mapPPMPixels<channels>(table, maxIterations, data, std::min(numPixels, perThread), out);
+    for (std::thread& w : workers)
+        w.join();
+}
+
+// Write numPixels counts as channels bytes each, one block at a time.
+template <int channels>
+static void writeGrayPixels(FILE *fp, const unsigned char* table, const int* data,
+                            size_t numPixels, int maxIterations)
+{
+    std::vector<unsigned char> buffer(channels * std::min(numPixels, PPM_BLOCK_PIXELS));
+
+    for (size_t first = 0; first < numPixels; first += PPM_BLOCK_PIXELS) {
+        size_t count = std::min(PPM_BLOCK_PIXELS, numPixels - first);
+        convertPPMPixels<channels>(table, data + first, count, maxIterations, buffer.data());
+        fwrite(buffer.data(), 1, channels * count, fp);
+    }
+}
+
+//
+// reportImageFile --
+//
+// Print the file name, its size and the encode throughput, measured in
+// MB of int iteration counts encoded per second so that all formats
+// compare on the same input.
 void
-writePPMImage(int* data, int width, int height, const char *filename, int maxIterations)
+reportImageFile(const char *filename, size_t numPixels, size_t fileBytes, double seconds)
+{
+    const double MB = 1024.0 * 1024.0;
+    printf("Wrote image file %s\t[encode %.3f ms, %.1f MB, %.0f MB/s]\n", filename,
+           seconds * 1000, fileBytes / MB, numPixels * sizeof(int) / MB / seconds);
+}
+
+//
+// beginPPMImage / writePPMRows / endPPMImage --
+//
+// Incremental form of writePPMImage: write the header, then any number
+// of consecutive row blocks, then close the file.  Used to stream
+// images that are never held in memory as a whole.  Rows always use
+// the fixed curve: equalization needs the histogram of the whole image.
+FILE*
+beginPPMImage(const char *filename, int width, int height)
 {
     FILE *fp = fopen(filename, "wb");
 
@@ -14,22 +228,96 @@ writePPMImage(int* data, int width, int height, const char *filename, int maxIte
     fprintf(fp, "P6\n");
     fprintf(fp, "%d %d\n", width, height);
     fprintf(fp, "255\n");
+    return fp;
+}
+
+void
+writePPMRows(FILE *fp, const int* data, int width, int numRows, int maxIterations)
+{
+    writeGrayPixels<3>(fp, ppmTable(maxIterations), data, (size_t)width * numRows, maxIterations);
+}
+
+void
+endPPMImage(FILE *fp, const char *filename)
+{
+    fclose(fp);
+    printf("Wrote image file %s\n", filename);
+}
 
-    for (int i = 0; i < width*height; ++i) {
+void
+writePPMImage(int* data, int width, int height, const char *filename, int maxIterations)
+{
+    double startTime = CycleTimer::currentSeconds();
+    size_t numPixels = (size_t)width * height;
+    std::vector<unsigned char> table;
+    const unsigned char* colors = imageTable(data, numPixels, maxIterations, table);
+    FILE *fp = beginPPMImage(filename, width, height);
+    writeGrayPixels<3>(fp, colors, data, numPixels, maxIterations);
+    long fileBytes = ftell(fp);
+    fclose(fp);
+    double endTime = CycleTimer::currentSeconds();
+    reportImageFile(filename, numPixels, fileBytes, endTime - startTime);
+}
 
-        // Clamp iteration count for this pixel, then scale the value
-        // to 0-1 range.  Raise resulting value to a power (<1) to
-        // increase brightness of low iteration count
-        // pixels. a.k.a. Make things look cooler.
+//
+// writePGMImage --
+//
+// Same gray levels as writePPMImage, stored once per pixel in a binary
+// PGM (P5) file, a third of the size.
+void
+writePGMImage(int* data, int width, int height, const char *filename, int maxIterations)
+{
+    double startTime = CycleTimer::currentSeconds();
+    size_t numPixels = (size_t)width * height;
+    std::vector<unsigned char> table;
+    const unsigned char* colors = imageTable(data, numPixels, maxIterations, table);
+    FILE *fp = fopen(filename, "wb");
+    fprintf(fp, "P5\n");
+    fprintf(fp, "%d %d\n", width, height);
+    fprintf(fp, "255\n");
+    writeGrayPixels<1>(fp, colors, data, numPixels, maxIterations);
+    long fileBytes = ftell(fp);
+    fclose(fp);
+    double endTime = CycleTimer::currentSeconds();
+    reportImageFile(filename, numPixels, fileBytes, endTime - startTime);
+}
 
-        float mapped = pow( std::min(static_cast<float>(maxIterations),
-                                     static_cast<float>(data[i])) / 256.f, .5f);
+//
+// writePPMImageTiled --
+//
+// Same as writePPMImage, but data is stored in the tiled layout described
+// by tileLayout.h and is converted back to linear order before writing.
+void
+writePPMImageTiled(int* data, int width, int height, int tileWidth, int tileHeight,
+                   const char *filename, int maxIterations)
+{
+    TileLayout layout = { width, height, tileWidth, tileHeight };
+    int* linear = new int[(size_t)width * height];
+    detileImage(layout, data, linear);
+    writePPMImage(linear, width, height, filename, maxIterations);
+    delete[] linear;
+}
 
-        // convert back into 0-255 range, 8-bit channels
-        unsigned char result = static_cast<unsigned char>(255.f * mapped);
-        for (int j = 0; j < 3; ++j)
-            fputc(result, fp);
+//
+// writePPMHeatmap --
+//
+// Write values in [0, 1] (clamped) as a red (0) - yellow - green (1)
+// heatmap, e.g. the SIMD efficiency of the gang that computed each
+// pixel.
+void
+writePPMHeatmap(const float* values, int width, int height, const char *filename)
+{
+    FILE *fp = beginPPMImage(filename, width, height);
+    std::vector<unsigned char> row(3 * (size_t)width);
+    for (int j = 0; j < height; ++j) {
+        const float* rowValues = values + (size_t)j * width;
+        for (int i = 0; i < width; ++i) {
+            float v = std::min(1.f, std::max(0.f, rowValues[i]));
+            row[3 * i] = static_cast<unsigned char>(255.f * std::min(1.f, 2.f - 2.f * v));
+            row[3 * i + 1] = static_cast<unsigned char>(255.f * std::min(1.f, 2.f * v));
+            row[3 * i + 2] = 0;
+        }
+        fwrite(row.data(), 1, row.size(), fp);
     }
-    fclose(fp);
-    printf("Wrote image file %s\n", filename);
+    endPPMImage(fp, filename);
 }
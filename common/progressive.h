@@ -0,0 +1,109 @@
+#ifndef _PROGRESSIVE_H_
+#define _PROGRESSIVE_H_
+
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+
+#include "CycleTimer.h"
+
+//
+// Progressive multi-resolution rendering --
+//
+// An image is rendered in passes of decreasing step: 8, 4, 2 and 1.
+// The pass with step s computes pixels (i, j) where both i and j are
+// multiples of s, except pixels already computed by the previous
+// (coarser) pass, and paints each one over its s x s block so the
+// partially rendered image is viewable after every pass.  A block never
+// covers another computed pixel, so each pixel is computed exactly once
+// and the final image equals a full-resolution render.
+
+static const int PROGRESSIVE_FIRST_STEP = 8;
+
+// First column, and distance between columns, computed in row j by the
+// pass with the given step; j must be a multiple of step.
+static inline void progressivePassColumns(int j, int step, int* first, int* stride)
+{
+    if (step != PROGRESSIVE_FIRST_STEP && j % (2 * step) == 0) {
+        *first = step;
+        *stride = 2 * step;
+    } else {
+        *first = 0;
+        *stride = step;
+    }
+}
+
+// Paint value over the step x step block at (i, j), clipped to the image.
+static inline void fillProgressiveBlock(int output[], int width, int height,
+                                        int i, int j, int step, int value)
+{
+    int iend = i + step < width ? i + step : width;
+    int jend = j + step < height ? j + step : height;
+    for (int y = j; y < jend; y++)
+        for (int x = i; x < iend; x++)
+            output[(size_t)y * width + x] = value;
+}
+
+//
+// CancelToken --
+//
+// Set by whoever issues a new viewport request; checked by renderers
+// between passes and between row chunks inside a pass.
+class CancelToken {
+public:
+    CancelToken() : cancelled_(false) {}
+
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    void reset() { cancelled_.store(false, std::memory_order_relaxed); }
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled_;
+};
+
+// Renders the pass with the given step into the output image.  Returns
+// false if it stopped early because of a cancellation.
+typedef std::function<bool(int step)> PassRenderer;
+
+// Called after each completed pass with the image as rendered so far.
+typedef std::function<void(int step, const int* output, double elapsedSeconds)> PassCallback;
+
+struct ProgressiveTimes {
+    double firstPass;   // seconds until the 1/8 resolution pass was done
+    double final;       // seconds until the full resolution pass was done
+    int lastStep;       // step of the last completed pass, 0 if none
+};
+
+//
+// renderProgressive --
+//
+// Run the 1/8, 1/4, 1/2 and full resolution passes in order, calling
+// onPass (if set) after each.  Stops as soon as cancel (if set) is
+// cancelled; returns true only if the full resolution pass completed.
+static inline bool renderProgressive(const PassRenderer& renderPass, const int* output,
+                                     const PassCallback& onPass, const CancelToken* cancel,
+                                     ProgressiveTimes* times)
+{
+    double startTime = CycleTimer::currentSeconds();
+    times->firstPass = times->final = 0.0;
+    times->lastStep = 0;
+
+    for (int step = PROGRESSIVE_FIRST_STEP; step >= 1; step /= 2) {
+        if (cancel && cancel->cancelled())
+            return false;
+        if (!renderPass(step))
+            return false;
+
+        double elapsed = CycleTimer::currentSeconds() - startTime;
+        if (step == PROGRESSIVE_FIRST_STEP)
+            times->firstPass = elapsed;
+        times->lastStep = step;
+        if (onPass)
+            onPass(step, output, elapsed);
+    }
+
+    times->final = CycleTimer::currentSeconds() - startTime;
+    return true;
+}
+
+#endif // _PROGRESSIVE_H_
@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "CycleTimer.h"
+
+extern void reportImageFile(const char *filename, size_t numPixels, size_t fileBytes,
+                            double seconds);
+extern int imageEncodeThreads();
+
+//
+// Raw and run-length encoded iteration counts --
+//
+// writeRawImage dumps the counts themselves for later reprocessing, as
+// int32 or as uint16 clamped to 65535, row major with no header, in
+// the byte order of the machine (little-endian on x86).
+//
+// writeRLEImage compresses the counts losslessly.  The image is cut
+// into bands of RLE_BAND_ROWS rows which are encoded independently, in
+// parallel.  A band is a sequence of runs of equal counts, each stored
+// as two LEB128 varints: the run length, and the zigzag-encoded
+// difference between its count and the previous run's (0 before the
+// first run of a band).  Interior points and smooth escape regions form
+// long runs, and neighboring runs differ by small deltas.
+//
+// RLE file layout, integers little-endian:
+//
+//     "MRLE"  uint32 width, height, bandRows, numBands
+//     uint64  encoded size of each band
+//     the encoded bands, in order
+
+static const int RLE_BAND_ROWS = 64;
+static const size_t RAW_BLOCK_PIXELS = (size_t)1 << 22;
+
+//
+// writeRawImage --
+//
+// bytesPerValue is 4 (int32) or 2 (uint16).
+void
+writeRawImage(const int* data, int width, int height, const char *filename, int bytesPerValue)
+{
+    double startTime = CycleTimer::currentSeconds();
+    size_t numPixels = (size_t)width * height;
+    FILE *fp = fopen(filename, "wb");
+
+    if (bytesPerValue == 4) {
+        fwrite(data, sizeof(int), numPixels, fp);
+    } else {
+        std::vector<uint16_t> buffer(std::min(numPixels, RAW_BLOCK_PIXELS));
+        int numThreads = imageEncodeThreads();
+        for (size_t first = 0; first < numPixels; first += RAW_BLOCK_PIXELS) {
+            size_t count = std::min(RAW_BLOCK_PIXELS, numPixels - first);
+            size_t perThread = (count + numThreads - 1) / numThreads;
+            auto convert = [&](int t) {
+                size_t begin = std::min(count, t * perThread);
+                size_t end = std::min(count, begin + perThread);
+                for (size_t i = begin; i < end; ++i)
+                    buffer[i] = (uint16_t)std::min(std::max(data[first + i], 0), 65535);
+            };
+            std::vector<std::thread> workers;
+            for (int t = 1; t < numThreads; ++t)
+                workers.push_back(std::thread(convert, t));
+            convert(0);
+            for (std::thread& w : workers)
+                w.join();
+            fwrite(buffer.data(), sizeof(uint16_t), count, fp);
+        }
+    }
+
+    long fileBytes = ftell(fp);
+    fclose(fp);
+    reportImageFile(filename, numPixels, fileBytes, CycleTimer::currentSeconds() - startTime);
+}
+
+static inline void putVarint(std::vector<unsigned char>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((unsigned char)value);
+}
+
+static inline bool getVarint(const unsigned char*& p, const unsigned char* end, uint64_t* value)
+{
+    uint64_t result = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char byte = *p++;
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void encodeBand(const int* data, size_t numPixels, std::vector<unsigned char>& out)
+{
+    out.clear();
+    int64_t previous = 0;
+    size_t i = 0;
+    while (i < numPixels) {
+        size_t run = 1;
+        while (i + run < numPixels && data[i + run] == data[i])
+            run++;
+
+        int64_t delta = (int64_t)data[i] - previous;
+        putVarint(out, run);
+        putVarint(out, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+        previous = data[i];
+        i += run;
+    }
+}
+
+static void putU32(FILE *fp, uint32_t value)
+{
+    fwrite(&value, sizeof(value), 1, fp);
+}
+
+//
+// writeRLEImage --
+//
+// Delta + run-length encode the counts (see above), one band per task,
+// bands handed out to the encoder threads from a shared counter.
+void
+writeRLEImage(const int* data, int width, int height, const char *filename)
+{
+    double startTime = CycleTimer::currentSeconds();
+    int numBands = (height + RLE_BAND_ROWS - 1) / RLE_BAND_ROWS;
+    std::vector<std::vector<unsigned char>> bands(numBands);
+
+    std::atomic<int> nextBand(0);
+    auto encode = [&]() {
+        int band;
+        while ((band = nextBand.fetch_add(1)) < numBands) {
+            int startRow = band * RLE_BAND_ROWS;
+            int numRows = std::min(RLE_BAND_ROWS, height - startRow);
+            encodeBand(data + (size_t)startRow * width, (size_t)numRows * width, bands[band]);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < std::min(imageEncodeThreads(), numBands); ++t)
+        workers.push_back(std::thread(encode));
+    encode();
+    for (std::thread& w : workers)
+        w.join();
+
+    FILE *fp = fopen(filename, "wb");
+    fwrite("MRLE", 1, 4, fp);
+    putU32(fp, width);
+    putU32(fp, height);
+    putU32(fp, RLE_BAND_ROWS);
+    putU32(fp, numBands);
+    for (int b = 0; b < numBands; ++b) {
+        uint64_t size = bands[b].size();
+        fwrite(&size, sizeof(size), 1, fp);
+    }
+    for (int b = 0; b < numBands; ++b)
+        fwrite(bands[b].data(), 1, bands[b].size(), fp);
+
+    long fileBytes = ftell(fp);
+    fclose(fp);
+    reportImageFile(filename, (size_t)width * height, fileBytes,
+                    CycleTimer::currentSeconds() - startTime);
+}
+
+//
+// readRLEImage --
+//
+// Decode a file written by writeRLEImage.  Returns false if the file is
+// missing or malformed.
+bool
+readRLEImage(const char *filename, std::vector<int>& data, int* width, int* height)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (!fp)
+        return false;
+    std::vector<unsigned char> file;
+    unsigned char chunk[1 << 16];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+        file.insert(file.end(), chunk, chunk + n);
+    fclose(fp);
+
+    uint32_t header[4];
+    if (file.size() < 4 + sizeof(header) || memcmp(file.data(), "MRLE", 4) != 0)
+        return false;
+    memcpy(header, file.data() + 4, sizeof(header));
+    uint32_t w = header[0], h = header[1], bandRows = header[2], numBands = header[3];
+    if (bandRows == 0 || numBands != (h + bandRows - 1) / bandRows)
+        return false;
+
+    size_t offset = 4 + sizeof(header);
+    if (file.size() < offset + numBands * sizeof(uint64_t))
+        return false;
+    std::vector<uint64_t> sizes(numBands);
+    memcpy(sizes.data(), file.data() + offset, numBands * sizeof(uint64_t));
+    offset += numBands * sizeof(uint64_t);
+
+    data.assign((size_t)w * h, 0);
+    for (uint32_t b = 0; b < numBands; ++b) {
+        if (sizes[b] > file.size() - offset)
+            return false;
+        const unsigned char* p = file.data() + offset;
+        const unsigned char* end = p + sizes[b];
+        offset += sizes[b];
+
+        size_t i = (size_t)b * bandRows * w;
+        size_t bandEnd = std::min((size_t)w * h, i + (size_t)bandRows * w);
+        int64_t previous = 0;
+        while (p < end) {
+            uint64_t run, zigzag;
+            if (!getVarint(p, end, &run) || !getVarint(p, end, &zigzag) || run > bandEnd - i)
+                return false;
+            previous += (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+            std::fill(data.begin() + i, data.begin() + i + run, (int)previous);
+            i += run;
+        }
+        if (i != bandEnd)
+            return false;
+    }
+
+    *width = (int)w;
+    *height = (int)h;
+    return true;
+}
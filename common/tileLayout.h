@@ -0,0 +1,65 @@
+#ifndef _TILE_LAYOUT_H_
+#define _TILE_LAYOUT_H_
+
+#include <stddef.h>
+
+//
+// TileLayout --
+//
+// Describes a width x height image split into tileWidth x tileHeight
+// tiles, numbered row-major.  Tiles on the right and bottom edges are
+// clipped to the image.
+//
+// In the tiled memory layout every tile is stored contiguously, row by
+// row, and tiles follow each other in tile order with no padding, so a
+// tiled image occupies exactly width * height elements just like the
+// linear one.
+struct TileLayout {
+    int width, height;
+    int tileWidth, tileHeight;
+
+    int tilesX() const { return (width + tileWidth - 1) / tileWidth; }
+    int tilesY() const { return (height + tileHeight - 1) / tileHeight; }
+    int numTiles() const { return tilesX() * tilesY(); }
+
+    // Pixel rectangle covered by tile.
+    void tileRect(int tile, int* x, int* y, int* w, int* h) const {
+        int tx = tile % tilesX();
+        int ty = tile / tilesX();
+        *x = tx * tileWidth;
+        *y = ty * tileHeight;
+        *w = (*x + tileWidth <= width) ? tileWidth : width - *x;
+        *h = (*y + tileHeight <= height) ? tileHeight : height - *y;
+    }
+
+    // Offset of the first element of tile in the tiled layout.  All
+    // tiles above it are full height rows of tiles, and the tiles to its
+    // left in its own tile row share its height.
+    size_t tileOffset(int tile) const {
+        int x, y, w, h;
+        tileRect(tile, &x, &y, &w, &h);
+        return (size_t)y * width + (size_t)x * h;
+    }
+};
+
+//
+// detileImage --
+//
+// Convert an image stored in the tiled layout back to the usual linear
+// row-major layout.
+template <typename T>
+void detileImage(const TileLayout& layout, const T* tiled, T* linear)
+{
+    for (int tile = 0; tile < layout.numTiles(); tile++) {
+        int x, y, w, h;
+        layout.tileRect(tile, &x, &y, &w, &h);
+        const T* src = tiled + layout.tileOffset(tile);
+        for (int j = 0; j < h; j++) {
+            T* dst = linear + (size_t)(y + j) * layout.width + x;
+            for (int i = 0; i < w; i++)
+                dst[i] = src[(size_t)j * w + i];
+        }
+    }
+}
+
+#endif // _TILE_LAYOUT_H_
@@ -0,0 +1,109 @@
+#ifndef _WORKER_POOL_H_
+#define _WORKER_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "threadPlacement.h"
+
+//
+// WorkerPool --
+//
+// A fixed set of long-lived worker threads that park on a condition
+// variable between jobs.  run() hands the same job to threads
+// 0..numThreads-1 and blocks until all of them have returned.  The
+// calling thread always executes job(0) itself, so a pool of size N
+// owns only N-1 std::threads, mirroring the spawn-per-call code in
+// mandelbrotThread().
+//
+// If cpus is non-empty, worker t pins itself to cpus[t] on startup.
+// Pinning thread 0 is left to the caller since it is the caller's own
+// thread.
+class WorkerPool {
+public:
+    explicit WorkerPool(int numThreads, const std::vector<int>& cpus = std::vector<int>())
+        : numThreads_(numThreads), cpus_(cpus), generation_(0), job_(NULL),
+          activeThreads_(0), pending_(0), shutdown_(false)
+    {
+        for (int i = 1; i < numThreads_; i++)
+            workers_.push_back(std::thread(&WorkerPool::workerLoop, this, i));
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            shutdown_ = true;
+        }
+        wake_.notify_all();
+        for (size_t i = 0; i < workers_.size(); i++)
+            workers_[i].join();
+    }
+
+    int size() const { return numThreads_; }
+    const std::vector<int>& cpus() const { return cpus_; }
+
+    // Run job(threadId) for threadId in [0, numThreads).  numThreads must
+    // not exceed size().
+    void run(int numThreads, const std::function<void(int)>& job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            activeThreads_ = numThreads;
+            pending_ = numThreads - 1;
+            generation_++;
+        }
+        wake_.notify_all();
+
+        job(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+        job_ = NULL;
+    }
+
+private:
+    void workerLoop(int threadId) {
+        if ((size_t)threadId < cpus_.size())
+            pinCurrentThread(cpus_[threadId]);
+
+        unsigned long long seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&] { return shutdown_ || generation_ != seen; });
+            if (shutdown_)
+                return;
+            seen = generation_;
+            if (threadId >= activeThreads_)
+                continue;
+
+            const std::function<void(int)>* job = job_;
+            lock.unlock();
+            (*job)(threadId);
+            lock.lock();
+
+            if (--pending_ == 0)
+                done_.notify_one();
+        }
+    }
+
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+
+    int numThreads_;
+    std::vector<int> cpus_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    unsigned long long generation_;
+    const std::function<void(int)>* job_;
+    int activeThreads_;
+    int pending_;
+    bool shutdown_;
+};
+
+#endif // _WORKER_POOL_H_
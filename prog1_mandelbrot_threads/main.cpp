@@ -1,8 +1,11 @@
 #include <stdio.h>
 #include <algorithm>
+#include <vector>
 #include <getopt.h>
 
 #include "CycleTimer.h"
+#include "tileLayout.h"
+#include "mandelbrotThread.h"
 
 extern void mandelbrotSerial(
     float x0, float y0, float x1, float y1,
@@ -11,10 +14,37 @@ extern void mandelbrotSerial(
     int maxIterations,
     int output[]);
 
-extern void mandelbrotThread(
-    int numThreads,
+extern void mandelbrotSerialEarlyOut(
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int startRow, int numRows,
+    int maxIterations,
+    int output[]);
+
+extern void mandelbrotSerialMariani(
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int startRow, int numRows,
+    int maxIterations,
+    int output[]);
+
+extern void mandelbrotSerialPass(
     float x0, float y0, float x1, float y1,
     int width, int height,
+    int startRow, int numRows,
+    int step,
+    int maxIterations,
+    int output[]);
+
+extern void mandelbrotSerialDouble(
+    double x0, double y0, double x1, double y1,
+    int width, int height,
+    int startRow, int numRows,
+    int maxIterations,
+    int output[]);
+
+extern void mandelbrotSerialDeep(
+    const DeepFrame& frame,
     int maxIterations,
     int output[]);
 
@@ -24,6 +54,52 @@ extern void writePPMImage(
     const char *filename,
     int maxIterations);
 
+extern FILE* beginPPMImage(
+    const char *filename,
+    int width, int height);
+
+extern void writePPMRows(
+    FILE *fp,
+    const int* data,
+    int width, int numRows,
+    int maxIterations);
+
+extern void endPPMImage(
+    FILE *fp,
+    const char *filename);
+
+extern void writePPMImageTiled(
+    int* data,
+    int width, int height,
+    int tileWidth, int tileHeight,
+    const char *filename,
+    int maxIterations);
+
+extern void setPPMEqualize(bool equalize);
+extern void setImageEncodeThreads(int numThreads);
+
+extern void writePGMImage(
+    int* data,
+    int width, int height,
+    const char *filename,
+    int maxIterations);
+
+extern void writeRawImage(
+    const int* data,
+    int width, int height,
+    const char *filename,
+    int bytesPerValue);
+
+extern void writeRLEImage(
+    const int* data,
+    int width, int height,
+    const char *filename);
+
+extern bool readRLEImage(
+    const char *filename,
+    std::vector<int>& data,
+    int* width, int* height);
+
 void
 scaleAndShift(float& x0, float& x1, float& y0, float& y1,
               float scale,
@@ -44,8 +120,35 @@ scaleAndShift(float& x0, float& x1, float& y0, float& y1,
 void usage(const char* progname) {
     printf("Usage: %s [options]\n", progname);
     printf("Program Options:\n");
-    printf("  -t  --threads <N>  Use N threads\n");
+    printf("  -t  --threads <N>  Use N threads (Default = hardware threads)\n");
     printf("  -v  --view <INT>   Use specified view settings\n");
+    printf("  -s  --sched <MODE> Row schedule: static, interleaved (default), dynamic or steal\n");
+    printf("  -x  --simd <ISA>   Row kernel: none (default), sse, avx2, avx512 or auto\n");
+    printf("  -T  --tile <WxH>   Schedule WxH tiles (e.g. 32x32, 64x16) instead of rows\n");
+    printf("  -L  --tiled-layout Store each tile contiguously in the output buffer\n");
+    printf("  -e  --early-out    Skip cardioid/bulb points and stop on periodic orbits\n");
+    printf("  -E  --early-out-sweep  Compare plain and early-out kernels at 256, 4096 and 65536 iterations\n");
+    printf("  -m  --mariani      Use Mariani-Silver subdivision (serial run is also timed with it)\n");
+    printf("  -p  --pin <POLICY> Thread placement: none (default), compact or numa\n");
+    printf("  -w  --sweep        Print speedup over serial for 1, 2, 4, ... threads\n");
+    printf("  -b  --bench <N>    Render N consecutive frames and report per-frame latency\n");
+    printf("  -W  --width <N>    Image width in pixels (Default = 1600)\n");
+    printf("  -H  --height <N>   Image height in pixels (Default = 1200)\n");
+    printf("  -i  --iters <N>    Maximum iterations per pixel (Default = 256)\n");
+    printf("  -c  --center <X,Y> Center the viewport on X+Yi\n");
+    printf("  -z  --scale <S>    Viewport height in the complex plane; width follows the aspect ratio\n");
+    printf("  -r  --repeat <N>   Time the best of N runs (Default = 5)\n");
+    printf("  -S  --stream <ROWS> Stream the image to mandelbrot-stream.ppm in bands of ROWS rows\n");
+    printf("                     without holding it in memory\n");
+    printf("  -P  --progressive  Render 1/8, 1/4, 1/2 and full resolution passes and report\n");
+    printf("                     time to first pass and to final image\n");
+    printf("  -n  --pan <FRAMES> Pan across FRAMES frames and compare the frame cache with full recompute\n");
+    printf("  -F  --formats      Also write the thread image as PGM, raw int32/uint16 counts and\n");
+    printf("                     delta+RLE, reporting encode throughput of each\n");
+    printf("  -q  --equalize     Color images by histogram equalization instead of a fixed curve\n");
+    printf("                     (use with high --iters; streamed images keep the fixed curve)\n");
+    printf("  -D  --deep         Render by double-precision perturbation (zooms down to ~1e-300);\n");
+    printf("                     --center is read to ~32 significant digits\n");
     printf("  -?  --help         This message\n");
 }
 
@@ -55,9 +158,10 @@ bool verifyResult (int *gold, int *result, int width, int height) {
 
     for (i = 0; i < height; i++) {
         for (j = 0; j < width; j++) {
-            if (gold[i * width + j] != result[i * width + j]) {
+            size_t index = (size_t)i * width + j;
+            if (gold[index] != result[index]) {
                 printf ("Mismatch : [%d][%d], Expected : %d, Actual : %d\n",
-                            i, j, gold[i * width + j], result[i * width + j]);
+                            i, j, gold[index], result[index]);
                 return 0;
             }
         }
@@ -66,12 +170,464 @@ bool verifyResult (int *gold, int *result, int width, int height) {
     return 1;
 }
 
+//
+// verifyThreadOutput --
+//
+// verifyResult for the threaded output, which may be stored in the
+// tiled layout.
+bool verifyThreadOutput(int *gold, int *result, int width, int height,
+                        int tileWidth, int tileHeight, bool tiledLayout) {
+
+    if (!tiledLayout)
+        return verifyResult(gold, result, width, height);
+
+    TileLayout layout = { width, height, tileWidth, tileHeight };
+    std::vector<int> linear((size_t)width * height);
+    detileImage(layout, result, linear.data());
+    return verifyResult(gold, linear.data(), width, height);
+}
+
+typedef void (*ThreadRenderFn)(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations,
+    int output[],
+    ScheduleMode schedule,
+    double busySeconds[]);
+
+//
+// benchFrames --
+//
+// Render numFrames consecutive frames with the given threaded entry
+// point and print the p50/p99/max per-frame latency.
+void benchFrames(const char* label, ThreadRenderFn render, int numFrames,
+                 int numThreads, ScheduleMode schedule,
+                 float x0, float y0, float x1, float y1,
+                 int width, int height, int maxIterations, int output[])
+{
+    std::vector<double> frameTimes(numFrames);
+    for (int f = 0; f < numFrames; ++f) {
+        double startTime = CycleTimer::currentSeconds();
+        render(numThreads, x0, y0, x1, y1, width, height, maxIterations, output, schedule, NULL);
+        double endTime = CycleTimer::currentSeconds();
+        frameTimes[f] = endTime - startTime;
+    }
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+    double p50 = frameTimes[(numFrames - 1) * 50 / 100];
+    // nearest rank, ceil(0.99 * numFrames) - 1: rounding down would
+    // report the median or less for small frame counts
+    double p99 = frameTimes[std::min(numFrames - 1, (numFrames * 99 + 99) / 100 - 1)];
+    printf("[%s]:\t[p50 %.3f] [p99 %.3f] [max %.3f] ms over %d frames\n",
+           label, p50 * 1000, p99 * 1000, frameTimes[numFrames - 1] * 1000, numFrames);
+}
+
+//
+// printBusyTimes --
+//
+// Print how long each thread spent computing, plus the ratio of the
+// slowest thread to the average as a measure of load imbalance.
+void printBusyTimes(const double busySeconds[], int numThreads)
+{
+    double maxBusy = 0.0, totalBusy = 0.0;
+    for (int i = 0; i < numThreads; ++i) {
+        printf("\t\t\t\t  thread %2d busy [%.3f] ms\n", i, busySeconds[i] * 1000);
+        maxBusy = std::max(maxBusy, busySeconds[i]);
+        totalBusy += busySeconds[i];
+    }
+    printf("\t\t\t\t  (max/avg busy %.2f)\n", maxBusy / (totalBusy / numThreads));
+}
+
+//
+// sweepThreads --
+//
+// Time the threaded renderer at 1, 2, 4, ... threads up to the number
+// of hardware threads (which is always included) and print speedup and
+// parallel efficiency relative to the serial time.
+void sweepThreads(double serialSeconds, ScheduleMode schedule,
+                  float x0, float y0, float x1, float y1,
+                  int width, int height, int maxIterations, int output[])
+{
+    int maxThreads = defaultThreadCount();
+    std::vector<int> counts;
+    for (int n = 1; n < maxThreads; n *= 2)
+        counts.push_back(n);
+    counts.push_back(maxThreads);
+
+    printf("threads\t      time (ms)\t speedup\tefficiency\n");
+    for (size_t c = 0; c < counts.size(); ++c) {
+        double minThread = 1e30;
+        for (int i = 0; i < 3; ++i) {
+            double startTime = CycleTimer::currentSeconds();
+            mandelbrotThread(counts[c], x0, y0, x1, y1, width, height, maxIterations, output, schedule);
+            double endTime = CycleTimer::currentSeconds();
+            minThread = std::min(minThread, endTime - startTime);
+        }
+        double speedup = serialSeconds / minThread;
+        printf("%7d\t%15.3f\t%7.2fx\t%9.1f%%\n",
+               counts[c], minThread * 1000, speedup, 100.0 * speedup / counts[c]);
+    }
+}
+
+//
+// sweepEarlyOut --
+//
+// Render the view with the threaded renderer at 256, 4096 and 65536
+// iterations, with and without the early-out kernel, and check that the
+// two images are identical.  Renders into its own buffers, so the
+// caller's serial and thread images are left as they were.
+bool sweepEarlyOut(int numThreads, ScheduleMode schedule,
+                   float x0, float y0, float x1, float y1,
+                   int width, int height)
+{
+    static const int iterationCounts[] = { 256, 4096, 65536 };
+    std::vector<int> plainImage((size_t)width * height);
+    std::vector<int> fastImage((size_t)width * height);
+    int* plain = plainImage.data();
+    int* fast = fastImage.data();
+
+    printf("iterations\t plain (ms)\tearly-out (ms)\t speedup\n");
+    for (unsigned int k = 0; k < sizeof(iterationCounts) / sizeof(iterationCounts[0]); ++k) {
+        int iters = iterationCounts[k];
+
+        setEarlyOut(false);
+        double startTime = CycleTimer::currentSeconds();
+        mandelbrotThread(numThreads, x0, y0, x1, y1, width, height, iters, plain, schedule);
+        double plainTime = CycleTimer::currentSeconds() - startTime;
+
+        setEarlyOut(true);
+        startTime = CycleTimer::currentSeconds();
+        mandelbrotThread(numThreads, x0, y0, x1, y1, width, height, iters, fast, schedule);
+        double fastTime = CycleTimer::currentSeconds() - startTime;
+
+        printf("%10d\t%11.3f\t%14.3f\t%7.2fx\n", iters, plainTime * 1000, fastTime * 1000, plainTime / fastTime);
+        if (! verifyResult (plain, fast, width, height)) {
+            printf ("Error : early-out output does not match plain kernel at %d iterations\n", iters);
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// setViewport --
+//
+// Make [x0, x1] x [y0, y1] the viewport of height scale centered on
+// (centerX, centerY), with the width chosen so pixels are square.
+void setViewport(float& x0, float& x1, float& y0, float& y1,
+                 float centerX, float centerY, float scale,
+                 int width, int height)
+{
+    float halfHeight = 0.5f * scale;
+    float halfWidth = halfHeight * width / height;
+    x0 = centerX - halfWidth;
+    x1 = centerX + halfWidth;
+    y0 = centerY - halfHeight;
+    y1 = centerY + halfHeight;
+}
+
+//
+// renderDeepZoom --
+//
+// Deep-zoom driver: compute the reference orbit of the view center,
+// render the frame serially and with threads, check that both agree,
+// and at zooms double can still resolve, compare against plain double
+// iteration.  Returns the process exit status.
+int renderDeepZoom(DoubleDouble centerX, DoubleDouble centerY, double scale,
+                   int width, int height, int maxIterations,
+                   int numThreads, ScheduleMode schedule, int repeat)
+{
+    DeepFrame frame;
+    double startTime = CycleTimer::currentSeconds();
+    prepareDeepFrame(centerX, centerY, scale, width, height, maxIterations, &frame);
+    double refTime = CycleTimer::currentSeconds() - startTime;
+
+    printf("Deep zoom at %.17g%+.17gi, scale %g (%g per pixel)\n",
+           centerX.hi, centerY.hi, scale, frame.pixelSize);
+    printf("[deep reference orbit]:\t\t[%.3f] ms (%d iterations%s)\n",
+           refTime * 1000, frame.refLength, frame.refLength < maxIterations ? ", escaped" : "");
+
+    size_t numPixels = (size_t)width * height;
+    std::vector<int> output_serial(numPixels);
+    std::vector<int> output_thread(numPixels);
+
+    double minSerial = 1e30;
+    for (int i = 0; i < repeat; ++i) {
+        startTime = CycleTimer::currentSeconds();
+        mandelbrotSerialDeep(frame, maxIterations, output_serial.data());
+        minSerial = std::min(minSerial, CycleTimer::currentSeconds() - startTime);
+    }
+    printf("[deep serial]:\t\t\t[%.3f] ms\n", minSerial * 1000);
+
+    double minThread = 1e30;
+    std::vector<double> busySeconds(numThreads);
+    for (int i = 0; i < repeat; ++i) {
+        startTime = CycleTimer::currentSeconds();
+        mandelbrotThreadDeep(numThreads, frame, maxIterations, output_thread.data(),
+                             schedule, busySeconds.data());
+        minThread = std::min(minThread, CycleTimer::currentSeconds() - startTime);
+    }
+    printf("[deep thread]:\t\t\t[%.3f] ms (%s schedule, %s kernel, %.1f frames/s)\n",
+           minThread * 1000, scheduleModeName(schedule), simdLevelName(getSimdLevel()),
+           1.0 / (minThread + refTime));
+    printBusyTimes(busySeconds.data(), numThreads);
+    writePPMImage(output_thread.data(), width, height, "mandelbrot-deep.ppm", maxIterations);
+
+    if (! verifyResult (output_serial.data(), output_thread.data(), width, height)) {
+        printf ("Error : Output from threads does not match serial deep-zoom output\n");
+        return 1;
+    }
+    printf("\t\t\t\t(%.2fx speedup from %d threads)\n", minSerial/minThread, numThreads);
+
+    // Plain double iteration still resolves pixels this large, so the
+    // two renderers should agree except for a few boundary pixels.
+    if (frame.pixelSize > 1e-13) {
+        double x0 = centerX.hi + frame.deltaX0;
+        double y0 = centerY.hi + frame.deltaY0;
+        mandelbrotSerialDouble(x0, y0, x0 + width * frame.pixelSize, y0 + height * frame.pixelSize,
+                               width, height, 0, height, maxIterations, output_serial.data());
+        size_t differ = 0;
+        for (size_t i = 0; i < numPixels; ++i)
+            differ += output_serial[i] != output_thread[i];
+        printf("\t\t\t\t(%.4f%% of pixels differ from plain double iteration)\n",
+               100.0 * differ / numPixels);
+    }
+
+    return 0;
+}
+
+//
+// printPass --
+//
+// Progress callback for the progressive renderers.
+void printPass(int step, const int*, double elapsedSeconds)
+{
+    printf("\t\t\t\t  1/%d pass done at [%.3f] ms\n", step, elapsedSeconds * 1000);
+}
+
+//
+// runProgressive --
+//
+// Progressive driver: render serially and with threads pass by pass,
+// check both final images against the plain serial render, then show a
+// cancellation by requesting a new viewport as soon as the first pass
+// of a threaded render is done.  Returns the process exit status.
+int runProgressive(float x0, float y0, float x1, float y1,
+                   int width, int height, int maxIterations, int numThreads)
+{
+    size_t numPixels = (size_t)width * height;
+    std::vector<int> gold(numPixels);
+    std::vector<int> output(numPixels);
+
+    double startTime = CycleTimer::currentSeconds();
+    mandelbrotSerial(x0, y0, x1, y1, width, height, 0, height, maxIterations, gold.data());
+    printf("[mandelbrot serial]:\t\t[%.3f] ms\n", (CycleTimer::currentSeconds() - startTime) * 1000);
+
+    ProgressiveTimes times;
+    renderProgressive([&](int step) {
+            mandelbrotSerialPass(x0, y0, x1, y1, width, height, 0, height, step, maxIterations, output.data());
+            return true;
+        }, output.data(), printPass, NULL, &times);
+    printf("[progressive serial]:\t\t[first pass %.3f] [final %.3f] ms\n",
+           times.firstPass * 1000, times.final * 1000);
+    if (! verifyResult (gold.data(), output.data(), width, height)) {
+        printf ("Error : Progressive serial output does not match serial output\n");
+        return 1;
+    }
+
+    std::fill(output.begin(), output.end(), 0);
+    renderProgressive([&](int step) {
+            return mandelbrotThreadPass(numThreads, x0, y0, x1, y1, width, height, maxIterations,
+                                        step, output.data());
+        }, output.data(), printPass, NULL, &times);
+    printf("[progressive thread]:\t\t[first pass %.3f] [final %.3f] ms (%d threads, %s kernel)\n",
+           times.firstPass * 1000, times.final * 1000, numThreads, simdLevelName(getSimdLevel()));
+    writePPMImage(output.data(), width, height, "mandelbrot-progressive.ppm", maxIterations);
+    if (! verifyResult (gold.data(), output.data(), width, height)) {
+        printf ("Error : Progressive thread output does not match serial output\n");
+        return 1;
+    }
+
+    // a new viewport request arrives right after the first pass
+    CancelToken cancel;
+    startTime = CycleTimer::currentSeconds();
+    bool completed = renderProgressive([&](int step) {
+            return mandelbrotThreadPass(numThreads, x0, y0, x1, y1, width, height, maxIterations,
+                                        step, output.data(), &cancel);
+        }, output.data(), [&cancel](int, const int*, double) { cancel.cancel(); }, &cancel, &times);
+    printf("[progressive cancelled]:\t[%.3f] ms (%s after the 1/%d pass)\n",
+           (CycleTimer::currentSeconds() - startTime) * 1000,
+           completed ? "not stopped" : "stopped", times.lastStep);
+
+    return 0;
+}
+
+// Pan per frame of the --pan animation, in pixels.
+static const int PAN_STEP_X = 6;
+static const int PAN_STEP_Y = 2;
+
+//
+// runPanAnimation --
+//
+// Pan benchmark: move the viewport by (PAN_STEP_X, PAN_STEP_Y) pixels per
+// frame and render every frame twice, once through a PanCache (only the
+// exposed strips) and once in full on the same pixel grid.  The two
+// frames must be identical.  Returns the process exit status.
+int runPanAnimation(float x0, float y0, float x1, float y1,
+                    int width, int height, int maxIterations, int numThreads, int numFrames)
+{
+    float dx = (x1 - x0) / width;
+    float dy = (y1 - y0) / height;
+
+    PanCache cache;
+    std::vector<int> full((size_t)width * height);
+    double cachedTime = 0.0, fullTime = 0.0;
+    size_t cachedPixels = 0;
+
+    for (int frame = 0; frame < numFrames; frame++) {
+        float fx0 = x0 + frame * PAN_STEP_X * dx;
+        float fy0 = y0 + frame * PAN_STEP_Y * dy;
+        float fx1 = fx0 + (x1 - x0);
+        float fy1 = fy0 + (y1 - y0);
+
+        PanRect rects[2];
+        double startTime = CycleTimer::currentSeconds();
+        int numRects = cache.update(fx0, fy0, fx1, fy1, width, height, rects);
+        mandelbrotThreadRects(numThreads, cache.anchorX0(), cache.anchorY0(),
+                              cache.anchorX1(), cache.anchorY1(), width, height, maxIterations,
+                              cache.colOffset(), cache.rowOffset(), rects, numRects, cache.frame());
+        cachedTime += CycleTimer::currentSeconds() - startTime;
+        for (int r = 0; r < numRects; r++)
+            cachedPixels += (size_t)rects[r].width * rects[r].height;
+
+        PanRect whole = { 0, 0, width, height };
+        startTime = CycleTimer::currentSeconds();
+        mandelbrotThreadRects(numThreads, cache.anchorX0(), cache.anchorY0(),
+                              cache.anchorX1(), cache.anchorY1(), width, height, maxIterations,
+                              cache.colOffset(), cache.rowOffset(), &whole, 1, full.data());
+        fullTime += CycleTimer::currentSeconds() - startTime;
+
+        if (! verifyResult (full.data(), cache.frame(), width, height)) {
+            printf ("Error : Cached frame %d does not match full recompute\n", frame);
+            return 1;
+        }
+    }
+
+    printf("[pan full recompute]:\t\t[%.3f] ms per frame (%.1f frames/s)\n",
+           fullTime * 1000 / numFrames, numFrames / fullTime);
+    printf("[pan frame cache]:\t\t[%.3f] ms per frame (%.1f frames/s, %.1f%% of pixels computed)\n",
+           cachedTime * 1000 / numFrames, numFrames / cachedTime,
+           100.0 * cachedPixels / ((double)width * height * numFrames));
+    printf("\t\t\t\t(%.2fx speedup from frame cache, %d frames of (%d, %d) pixels)\n",
+           fullTime / cachedTime, numFrames, PAN_STEP_X, PAN_STEP_Y);
+    writePPMImage(cache.frame(), width, height, "mandelbrot-pan.ppm", maxIterations);
+    return 0;
+}
+
+// Streamed images up to this many pixels are also checked against a
+// full-size serial render.
+static const size_t STREAM_VERIFY_PIXELS = (size_t)1 << 26;
+
+//
+// streamImage --
+//
+// Streaming driver: render in bands with mandelbrotThreadStream and
+// write each band to the PPM file as soon as it is next in order.  When
+// the image is small enough, stream it a second time and compare every
+// band with the serial render.  Returns the process exit status.
+int streamImage(float x0, float y0, float x1, float y1,
+                int width, int height, int maxIterations,
+                int numThreads, int bandRows)
+{
+    const char* filename = "mandelbrot-stream.ppm";
+    FILE* fp = beginPPMImage(filename, width, height);
+
+    double startTime = CycleTimer::currentSeconds();
+    int numSlots = mandelbrotThreadStream(numThreads, x0, y0, x1, y1, width, height, maxIterations, bandRows,
+        [fp, width, maxIterations](const int* rows, int, int numRows) {
+            writePPMRows(fp, rows, width, numRows, maxIterations);
+        });
+    double endTime = CycleTimer::currentSeconds();
+    endPPMImage(fp, filename);
+
+    printf("[mandelbrot stream]:\t\t[%.3f] ms (%d-row bands, %d buffered, %.1f MB)\n",
+           (endTime - startTime) * 1000, bandRows, numSlots,
+           (double)numSlots * bandRows * width * sizeof(int) / (1024 * 1024));
+
+    size_t numPixels = (size_t)width * height;
+    if (numPixels > STREAM_VERIFY_PIXELS) {
+        printf("\t\t\t\t(image too large to verify against a serial render)\n");
+        return 0;
+    }
+
+    std::vector<int> gold(numPixels);
+    mandelbrotSerial(x0, y0, x1, y1, width, height, 0, height, maxIterations, gold.data());
+    bool correct = true;
+    int expectedRow = 0;
+    mandelbrotThreadStream(numThreads, x0, y0, x1, y1, width, height, maxIterations, bandRows,
+        [&](const int* rows, int startRow, int numRows) {
+            correct = correct && startRow == expectedRow &&
+                      verifyResult(gold.data() + (size_t)startRow * width, const_cast<int*>(rows), width, numRows);
+            expectedRow = startRow + numRows;
+        });
+    if (!correct || expectedRow != height) {
+        printf ("Error : Streamed output does not match serial output\n");
+        return 1;
+    }
+    return 0;
+}
+
+//
+// writeImageFormats --
+//
+// Write data in every supported output format next to the PPM, then
+// read the RLE file back to check that it is lossless.
+bool writeImageFormats(int* data, int width, int height, int maxIterations)
+{
+    writePGMImage(data, width, height, "mandelbrot-thread.pgm", maxIterations);
+    writeRawImage(data, width, height, "mandelbrot-thread.raw32", 4);
+    writeRawImage(data, width, height, "mandelbrot-thread.raw16", 2);
+    writeRLEImage(data, width, height, "mandelbrot-thread.rle");
+
+    std::vector<int> decoded;
+    int decodedWidth, decodedHeight;
+    if (!readRLEImage("mandelbrot-thread.rle", decoded, &decodedWidth, &decodedHeight) ||
+        decodedWidth != width || decodedHeight != height ||
+        !std::equal(decoded.begin(), decoded.end(), data)) {
+        printf("Error : mandelbrot-thread.rle does not decode to the rendered image\n");
+        return false;
+    }
+    return true;
+}
+
 int main(int argc, char** argv) {
 
-    const unsigned int width = 1600;
-    const unsigned int height = 1200;
-    const int maxIterations = 256;
-    int numThreads = 2;
+    int width = 1600;
+    int height = 1200;
+    int maxIterations = 256;
+    int repeat = 5;
+    bool centerSet = false;
+    float centerX = 0.f, centerY = 0.f;
+    double viewScale = 0.0;
+    const char* centerArg = NULL;
+    bool deep = false;
+    int streamRows = 0;
+    bool progressive = false;
+    int panFrames = 0;
+    bool writeFormats = false;
+    int numThreads = defaultThreadCount();
+    int benchFrameCount = 0;
+    bool sweep = false;
+    ScheduleMode schedule = SCHED_INTERLEAVED;
+    PinPolicy pinPolicy = PIN_NONE;
+    SimdLevel simdLevel = SIMD_NONE;
+    int tileWidth = 0;
+    int tileHeight = 0;
+    bool tiledLayout = false;
+    bool mariani = false;
+    bool earlyOut = false;
+    bool earlyOutSweep = false;
 
     float x0 = -2;
     float x1 = 1;
@@ -83,16 +639,44 @@ int main(int argc, char** argv) {
     static struct option long_options[] = {
         {"threads", 1, 0, 't'},
         {"view", 1, 0, 'v'},
+        {"sched", 1, 0, 's'},
+        {"simd", 1, 0, 'x'},
+        {"tile", 1, 0, 'T'},
+        {"tiled-layout", 0, 0, 'L'},
+        {"early-out", 0, 0, 'e'},
+        {"early-out-sweep", 0, 0, 'E'},
+        {"mariani", 0, 0, 'm'},
+        {"pin", 1, 0, 'p'},
+        {"sweep", 0, 0, 'w'},
+        {"bench", 1, 0, 'b'},
+        {"width", 1, 0, 'W'},
+        {"height", 1, 0, 'H'},
+        {"iters", 1, 0, 'i'},
+        {"center", 1, 0, 'c'},
+        {"scale", 1, 0, 'z'},
+        {"repeat", 1, 0, 'r'},
+        {"deep", 0, 0, 'D'},
+        {"stream", 1, 0, 'S'},
+        {"progressive", 0, 0, 'P'},
+        {"pan", 1, 0, 'n'},
+        {"formats", 0, 0, 'F'},
+        {"equalize", 0, 0, 'q'},
         {"help", 0, 0, '?'},
         {0 ,0, 0, 0}
     };
 
-    while ((opt = getopt_long(argc, argv, "t:v:?", long_options, NULL)) != EOF) {
+    while ((opt = getopt_long(argc, argv, "t:v:s:x:T:LeEmp:wb:W:H:i:c:z:r:DS:Pn:Fq?", long_options, NULL)) != EOF) {
 
         switch (opt) {
         case 't':
         {
             numThreads = atoi(optarg);
+            if (numThreads <= 0) {
+                fprintf(stderr, "Invalid thread count\n");
+                return 1;
+            }
+            // encode images with as many threads as render them
+            setImageEncodeThreads(numThreads);
             break;
         }
         case 'v':
@@ -110,6 +694,142 @@ int main(int argc, char** argv) {
             }
             break;
         }
+        case 's':
+        {
+            if (!parseScheduleMode(optarg, &schedule)) {
+                fprintf(stderr, "Invalid schedule %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 'x':
+        {
+            if (!parseSimdLevel(optarg, &simdLevel)) {
+                fprintf(stderr, "Invalid SIMD level %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 'T':
+        {
+            if (sscanf(optarg, "%dx%d", &tileWidth, &tileHeight) != 2 ||
+                tileWidth <= 0 || tileHeight <= 0) {
+                fprintf(stderr, "Invalid tile size %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 'L':
+            tiledLayout = true;
+            break;
+        case 'e':
+            earlyOut = true;
+            break;
+        case 'E':
+            earlyOutSweep = true;
+            break;
+        case 'm':
+            mariani = true;
+            break;
+        case 'p':
+        {
+            if (!parsePinPolicy(optarg, &pinPolicy)) {
+                fprintf(stderr, "Invalid pin policy %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 'w':
+            sweep = true;
+            break;
+        case 'b':
+        {
+            benchFrameCount = atoi(optarg);
+            if (benchFrameCount <= 0) {
+                fprintf(stderr, "Invalid frame count\n");
+                return 1;
+            }
+            break;
+        }
+        case 'W':
+        case 'H':
+        {
+            int size = atoi(optarg);
+            if (size <= 0) {
+                fprintf(stderr, "Invalid image %s %s\n", opt == 'W' ? "width" : "height", optarg);
+                return 1;
+            }
+            if (opt == 'W')
+                width = size;
+            else
+                height = size;
+            break;
+        }
+        case 'i':
+        {
+            maxIterations = atoi(optarg);
+            if (maxIterations <= 0) {
+                fprintf(stderr, "Invalid iteration count %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 'c':
+        {
+            if (sscanf(optarg, "%f,%f", &centerX, &centerY) != 2) {
+                fprintf(stderr, "Invalid center %s\n", optarg);
+                return 1;
+            }
+            centerSet = true;
+            centerArg = optarg;
+            break;
+        }
+        case 'z':
+        {
+            viewScale = atof(optarg);
+            if (!(viewScale > 0.0)) {
+                fprintf(stderr, "Invalid scale %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 'r':
+        {
+            repeat = atoi(optarg);
+            if (repeat <= 0) {
+                fprintf(stderr, "Invalid repeat count %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
+        case 'D':
+            deep = true;
+            break;
+        case 'P':
+            progressive = true;
+            break;
+        case 'n':
+            panFrames = atoi(optarg);
+            if (panFrames <= 0) {
+                fprintf(stderr, "Invalid frame count %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'F':
+            writeFormats = true;
+            break;
+        case 'q':
+            setPPMEqualize(true);
+            break;
+        case 'S':
+        {
+            streamRows = atoi(optarg);
+            if (streamRows <= 0) {
+                fprintf(stderr, "Invalid band height %s\n", optarg);
+                return 1;
+            }
+            break;
+        }
         case '?':
         default:
             usage(argv[0]);
@@ -118,18 +838,68 @@ int main(int argc, char** argv) {
     }
     // end parsing of commandline options
 
+    // --center and --scale override the view; whichever is missing is
+    // taken from it
+    if (centerSet || viewScale > 0.0) {
+        if (!centerSet) {
+            centerX = 0.5f * (x0 + x1);
+            centerY = 0.5f * (y0 + y1);
+        }
+        if (viewScale <= 0.0)
+            viewScale = y1 - y0;
+        setViewport(x0, x1, y0, y1, centerX, centerY, viewScale, width, height);
+    }
+
+    setThreadPlacement(pinPolicy);
+    setSimdLevel(simdLevel);
+
+    if (tiledLayout && tileWidth == 0) {
+        fprintf(stderr, "--tiled-layout requires --tile\n");
+        return 1;
+    }
+    setTiling(tileWidth, tileHeight, tiledLayout);
+    setMarianiSilver(mariani);
+    setEarlyOut(earlyOut);
+
+    if (progressive)
+        return runProgressive(x0, y0, x1, y1, width, height, maxIterations, numThreads);
+
+    if (panFrames > 0)
+        return runPanAnimation(x0, y0, x1, y1, width, height, maxIterations, numThreads, panFrames);
+
+    if (streamRows > 0)
+        return streamImage(x0, y0, x1, y1, width, height, maxIterations, numThreads, streamRows);
+
+    if (deep) {
+        DoubleDouble centerReal = ddFromDouble(0.5 * ((double)x0 + x1));
+        DoubleDouble centerImag = ddFromDouble(0.5 * ((double)y0 + y1));
+        if (centerArg) {
+            const char* rest = ddParse(centerArg, &centerReal);
+            if (rest == NULL || *rest != ',' || ddParse(rest + 1, &centerImag) == NULL) {
+                fprintf(stderr, "Invalid center %s\n", centerArg);
+                return 1;
+            }
+        }
+        return renderDeepZoom(centerReal, centerImag, viewScale > 0.0 ? viewScale : y1 - y0,
+                              width, height, maxIterations, numThreads, schedule, repeat);
+    }
+
+
+    size_t numPixels = (size_t)width * height;
+    int* output_serial = new int[numPixels];
+    int* output_thread = new int[numPixels];
+
+    printf("Rendering %dx%d, %d iterations, view [%g, %g] x [%g, %g]\n",
+           width, height, maxIterations, x0, x1, y0, y1);
 
-    int* output_serial = new int[width*height];
-    int* output_thread = new int[width*height];
-    
     //
-    // Run the serial implementation.  Run the code three times and
+    // Run the serial implementation.  Run the code repeat times and
     // take the minimum to get a good estimate.
     //
 
     double minSerial = 1e30;
-    for (int i = 0; i < 5; ++i) {
-        memset(output_serial, 0, width * height * sizeof(int));
+    for (int i = 0; i < repeat; ++i) {
+        memset(output_serial, 0, numPixels * sizeof(int));
         double startTime = CycleTimer::currentSeconds();
         mandelbrotSerial(x0, y0, x1, y1, width, height, 0, height, maxIterations, output_serial);
         double endTime = CycleTimer::currentSeconds();
@@ -139,23 +909,91 @@ int main(int argc, char** argv) {
     printf("[mandelbrot serial]:\t\t[%.3f] ms\n", minSerial * 1000);
     writePPMImage(output_serial, width, height, "mandelbrot-serial.ppm", maxIterations);
 
+    //
+    // Serial early-out kernel, checked against the plain kernel
+    //
+
+    if (earlyOut) {
+        double minEarlyOut = 1e30;
+        for (int i = 0; i < repeat; ++i) {
+            memset(output_thread, 0, numPixels * sizeof(int));
+            double startTime = CycleTimer::currentSeconds();
+            mandelbrotSerialEarlyOut(x0, y0, x1, y1, width, height, 0, height, maxIterations, output_thread);
+            double endTime = CycleTimer::currentSeconds();
+            minEarlyOut = std::min(minEarlyOut, endTime - startTime);
+        }
+
+        printf("[mandelbrot serial early-out]:\t[%.3f] ms\n", minEarlyOut * 1000);
+
+        if (! verifyResult (output_serial, output_thread, width, height)) {
+            printf ("Error : early-out output does not match serial output\n");
+
+            delete[] output_serial;
+            delete[] output_thread;
+
+            return 1;
+        }
+        printf("\t\t\t\t(%.2fx speedup from early-out)\n", minSerial/minEarlyOut);
+    }
+
+    //
+    // Serial Mariani-Silver subdivision, checked against brute force
+    //
+
+    if (mariani) {
+        double minMariani = 1e30;
+        for (int i = 0; i < repeat; ++i) {
+            memset(output_thread, 0, numPixels * sizeof(int));
+            double startTime = CycleTimer::currentSeconds();
+            mandelbrotSerialMariani(x0, y0, x1, y1, width, height, 0, height, maxIterations, output_thread);
+            double endTime = CycleTimer::currentSeconds();
+            minMariani = std::min(minMariani, endTime - startTime);
+        }
+
+        printf("[mandelbrot serial mariani]:\t[%.3f] ms\n", minMariani * 1000);
+
+        if (! verifyResult (output_serial, output_thread, width, height)) {
+            printf ("Error : Mariani-Silver output does not match serial output\n");
+
+            delete[] output_serial;
+            delete[] output_thread;
+
+            return 1;
+        }
+        printf("\t\t\t\t(%.2fx speedup from Mariani-Silver)\n", minSerial/minMariani);
+    }
+
     //
     // Run the threaded version
     //
 
     double minThread = 1e30;
-    for (int i = 0; i < 1; ++i) {
-        memset(output_thread, 0, width * height * sizeof(int));
+    std::vector<double> busySeconds(numThreads);
+    for (int i = 0; i < repeat; ++i) {
+        memset(output_thread, 0, numPixels * sizeof(int));
         double startTime = CycleTimer::currentSeconds();
-        mandelbrotThread(numThreads, x0, y0, x1, y1, width, height, maxIterations, output_thread);
+        mandelbrotThread(numThreads, x0, y0, x1, y1, width, height, maxIterations, output_thread,
+                         schedule, busySeconds.data());
         double endTime = CycleTimer::currentSeconds();
         minThread = std::min(minThread, endTime - startTime);
     }
 
-    printf("[mandelbrot thread]:\t\t[%.3f] ms\n", minThread * 1000);
-    writePPMImage(output_thread, width, height, "mandelbrot-thread.ppm", maxIterations);
+    printf("[mandelbrot thread]:\t\t[%.3f] ms (%s schedule, %s kernel",
+           minThread * 1000, scheduleModeName(schedule), simdLevelName(getSimdLevel()));
+    if (tileWidth > 0)
+        printf(", %dx%d tiles%s", tileWidth, tileHeight, tiledLayout ? " stored tiled" : "");
+    if (mariani)
+        printf(", mariani-silver");
+    if (earlyOut)
+        printf(", early-out");
+    printf(")\n");
+    printBusyTimes(busySeconds.data(), numThreads);
+    if (tiledLayout)
+        writePPMImageTiled(output_thread, width, height, tileWidth, tileHeight, "mandelbrot-thread.ppm", maxIterations);
+    else
+        writePPMImage(output_thread, width, height, "mandelbrot-thread.ppm", maxIterations);
 
-    if (! verifyResult (output_serial, output_thread, width, height)) {
+    if (! verifyThreadOutput (output_serial, output_thread, width, height, tileWidth, tileHeight, tiledLayout)) {
         printf ("Error : Output from threads does not match serial output\n");
 
         delete[] output_serial;
@@ -167,6 +1005,50 @@ int main(int argc, char** argv) {
     // compute speedup
     printf("\t\t\t\t(%.2fx speedup from %d threads)\n", minSerial/minThread, numThreads);
 
+    // output_serial is always in linear order and matches the thread output
+    if (writeFormats && !writeImageFormats(output_serial, width, height, maxIterations)) {
+        delete[] output_serial;
+        delete[] output_thread;
+
+        return 1;
+    }
+
+    if (sweep) {
+        sweepThreads(minSerial, schedule, x0, y0, x1, y1, width, height, maxIterations, output_thread);
+    }
+
+    if (earlyOutSweep) {
+        bool sweepCorrect = sweepEarlyOut(numThreads, schedule, x0, y0, x1, y1, width, height);
+        setEarlyOut(earlyOut);
+        if (!sweepCorrect) {
+            delete[] output_serial;
+            delete[] output_thread;
+
+            return 1;
+        }
+    }
+
+    //
+    // Per-frame latency of spawning threads on every call versus
+    // dispatching to the persistent worker pool
+    //
+
+    if (benchFrameCount > 0) {
+        benchFrames("spawn per frame", mandelbrotThreadSpawn, benchFrameCount, numThreads, schedule,
+                    x0, y0, x1, y1, width, height, maxIterations, output_thread);
+        benchFrames("worker pool", mandelbrotThread, benchFrameCount, numThreads, schedule,
+                    x0, y0, x1, y1, width, height, maxIterations, output_thread);
+
+        if (! verifyThreadOutput (output_serial, output_thread, width, height, tileWidth, tileHeight, tiledLayout)) {
+            printf ("Error : Output from worker pool does not match serial output\n");
+
+            delete[] output_serial;
+            delete[] output_thread;
+
+            return 1;
+        }
+    }
+
     delete[] output_serial;
     delete[] output_thread;
 
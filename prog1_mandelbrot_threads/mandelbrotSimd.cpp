@@ -0,0 +1,343 @@
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MANDEL_SIMD_X86
+#endif
+
+#include "mandelbrotSimd.h"
+
+bool parseSimdLevel(const char* name, SimdLevel* level)
+{
+    static const SimdLevel levels[] = { SIMD_NONE, SIMD_SSE, SIMD_AVX2, SIMD_AVX512, SIMD_AUTO };
+    for (unsigned int i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        if (strcmp(name, simdLevelName(levels[i])) == 0) {
+            *level = levels[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+    switch (level) {
+    case SIMD_NONE:   return "none";
+    case SIMD_SSE:    return "sse";
+    case SIMD_AVX2:   return "avx2";
+    case SIMD_AVX512: return "avx512";
+    case SIMD_AUTO:   return "auto";
+    }
+    return "unknown";
+}
+
+#ifdef MANDEL_SIMD_X86
+
+static SimdLevel bestSupportedLevel()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return SIMD_SSE;
+    return SIMD_NONE;
+}
+
+SimdLevel resolveSimdLevel(SimdLevel requested)
+{
+    SimdLevel best = bestSupportedLevel();
+    if (requested == SIMD_AUTO || requested > best)
+        return best;
+    return requested;
+}
+
+//
+// Each kernel below mirrors mandel():
+//
+//     for (i = 0; i < count; ++i) {
+//         if (z_re * z_re + z_im * z_im > 4.f) break;
+//         new_re = z_re*z_re - z_im*z_im;  new_im = 2.f * z_re * z_im;
+//         z_re = c_re + new_re;  z_im = c_im + new_im;
+//     }
+//
+// A lane stays active while !(|z|^2 > 4), an unordered compare so NaN
+// behaves as in the scalar loop, and its count advances only while
+// active.  Inactive lanes keep iterating harmlessly until the whole
+// vector has escaped.  Pixel indices are formed as (float)i + lane,
+// which equals (float)(i + lane) for any column below 2^24.
+
+__attribute__((target("sse2")))
+static int mandelRowSSE(float x0, float dx, float y, int startCol, int endCol, int maxIterations, int output[])
+{
+    const __m128 four = _mm_set1_ps(4.f);
+    const __m128 two = _mm_set1_ps(2.f);
+    const __m128 vdx = _mm_set1_ps(dx);
+    const __m128 vx0 = _mm_set1_ps(x0);
+    const __m128 lane = _mm_setr_ps(0, 1, 2, 3);
+
+    int i = startCol;
+    for (; i + 4 <= endCol; i += 4) {
+        __m128 c_re = _mm_add_ps(vx0, _mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)i), lane), vdx));
+        __m128 c_im = _mm_set1_ps(y);
+        __m128 z_re = c_re, z_im = c_im;
+        __m128 active = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        __m128i count = _mm_setzero_si128();
+
+        for (int it = 0; it < maxIterations; ++it) {
+            __m128 re2 = _mm_mul_ps(z_re, z_re);
+            __m128 im2 = _mm_mul_ps(z_im, z_im);
+            active = _mm_and_ps(active, _mm_cmpngt_ps(_mm_add_ps(re2, im2), four));
+            if (_mm_movemask_ps(active) == 0)
+                break;
+            count = _mm_sub_epi32(count, _mm_castps_si128(active));
+
+            __m128 new_re = _mm_sub_ps(re2, im2);
+            __m128 new_im = _mm_mul_ps(_mm_mul_ps(two, z_re), z_im);
+            z_re = _mm_add_ps(c_re, new_re);
+            z_im = _mm_add_ps(c_im, new_im);
+        }
+
+        _mm_storeu_si128((__m128i*)(output + (i - startCol)), count);
+    }
+    return i - startCol;
+}
+
+__attribute__((target("avx2")))
+static int mandelRowAVX2(float x0, float dx, float y, int startCol, int endCol, int maxIterations, int output[])
+{
+    const __m256 four = _mm256_set1_ps(4.f);
+    const __m256 two = _mm256_set1_ps(2.f);
+    const __m256 vdx = _mm256_set1_ps(dx);
+    const __m256 vx0 = _mm256_set1_ps(x0);
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+
+    int i = startCol;
+    for (; i + 8 <= endCol; i += 8) {
+        __m256 c_re = _mm256_add_ps(vx0, _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps((float)i), lane), vdx));
+        __m256 c_im = _mm256_set1_ps(y);
+        __m256 z_re = c_re, z_im = c_im;
+        __m256 active = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        __m256i count = _mm256_setzero_si256();
+
+        for (int it = 0; it < maxIterations; ++it) {
+            __m256 re2 = _mm256_mul_ps(z_re, z_re);
+            __m256 im2 = _mm256_mul_ps(z_im, z_im);
+            active = _mm256_and_ps(active, _mm256_cmp_ps(_mm256_add_ps(re2, im2), four, _CMP_NGT_UQ));
+            if (_mm256_movemask_ps(active) == 0)
+                break;
+            count = _mm256_sub_epi32(count, _mm256_castps_si256(active));
+
+            __m256 new_re = _mm256_sub_ps(re2, im2);
+            __m256 new_im = _mm256_mul_ps(_mm256_mul_ps(two, z_re), z_im);
+            z_re = _mm256_add_ps(c_re, new_re);
+            z_im = _mm256_add_ps(c_im, new_im);
+        }
+
+        _mm256_storeu_si256((__m256i*)(output + (i - startCol)), count);
+    }
+    return i - startCol;
+}
+
+__attribute__((target("avx512f")))
+static int mandelRowAVX512(float x0, float dx, float y, int startCol, int endCol, int maxIterations, int output[])
+{
+    const __m512 four = _mm512_set1_ps(4.f);
+    const __m512 two = _mm512_set1_ps(2.f);
+    const __m512 vdx = _mm512_set1_ps(dx);
+    const __m512 vx0 = _mm512_set1_ps(x0);
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512 lane = _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    int i = startCol;
+    for (; i + 16 <= endCol; i += 16) {
+        __m512 c_re = _mm512_add_ps(vx0, _mm512_mul_ps(_mm512_add_ps(_mm512_set1_ps((float)i), lane), vdx));
+        __m512 c_im = _mm512_set1_ps(y);
+        __m512 z_re = c_re, z_im = c_im;
+        __mmask16 active = 0xFFFF;
+        __m512i count = _mm512_setzero_si512();
+
+        for (int it = 0; it < maxIterations; ++it) {
+            __m512 re2 = _mm512_mul_ps(z_re, z_re);
+            __m512 im2 = _mm512_mul_ps(z_im, z_im);
+            active = _mm512_mask_cmp_ps_mask(active, _mm512_add_ps(re2, im2), four, _CMP_NGT_UQ);
+            if (active == 0)
+                break;
+            count = _mm512_mask_add_epi32(count, active, count, one);
+
+            __m512 new_re = _mm512_sub_ps(re2, im2);
+            __m512 new_im = _mm512_mul_ps(_mm512_mul_ps(two, z_re), z_im);
+            z_re = _mm512_add_ps(c_re, new_re);
+            z_im = _mm512_add_ps(c_im, new_im);
+        }
+
+        _mm512_storeu_si512((void*)(output + (i - startCol)), count);
+    }
+    return i - startCol;
+}
+
+int mandelRowSimd(SimdLevel level,
+                  float x0, float dx, float y,
+                  int startCol, int endCol, int maxIterations,
+                  int output[])
+{
+    switch (level) {
+    case SIMD_SSE:    return mandelRowSSE(x0, dx, y, startCol, endCol, maxIterations, output);
+    case SIMD_AVX2:   return mandelRowAVX2(x0, dx, y, startCol, endCol, maxIterations, output);
+    case SIMD_AVX512: return mandelRowAVX512(x0, dx, y, startCol, endCol, maxIterations, output);
+    default:          return 0;
+    }
+}
+
+//
+// The perturbation kernels mirror deepPixel() the same way.  Each lane
+// keeps its own reference index m (64-bit, so it can feed the gathers
+// directly); an escaped lane stops advancing m, so every gather stays
+// inside the reference orbit.  Escaped lanes keep computing deltas that
+// are never used.
+
+__attribute__((target("avx2")))
+static int deepRowAVX2(const DeepFrame& frame, int j, int startCol, int endCol, int maxIterations, int output[])
+{
+    const double* ref_re = frame.refRe.data();
+    const double* ref_im = frame.refIm.data();
+    const __m256d four = _mm256_set1_pd(4.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d pixel = _mm256_set1_pd(frame.pixelSize);
+    const __m256d vdx0 = _mm256_set1_pd(frame.deltaX0);
+    const __m256d lane = _mm256_setr_pd(0, 1, 2, 3);
+    const __m256i last = _mm256_set1_epi64x(frame.refLength);
+
+    int i = startCol;
+    for (; i + 4 <= endCol; i += 4) {
+        __m256d dc_re = _mm256_add_pd(vdx0, _mm256_mul_pd(_mm256_add_pd(_mm256_set1_pd((double)i), lane), pixel));
+        __m256d dc_im = _mm256_set1_pd(frame.deltaY0 + j * frame.pixelSize);
+        __m256d d_re = _mm256_setzero_pd(), d_im = _mm256_setzero_pd();
+        __m256i m = _mm256_setzero_si256();
+        __m256d active = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+        __m256i count = _mm256_setzero_si256();
+
+        for (int it = 0; it < maxIterations; ++it) {
+            __m256d t_re = _mm256_add_pd(_mm256_mul_pd(two, _mm256_i64gather_pd(ref_re, m, 8)), d_re);
+            __m256d t_im = _mm256_add_pd(_mm256_mul_pd(two, _mm256_i64gather_pd(ref_im, m, 8)), d_im);
+            __m256d new_re = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(t_re, d_re), _mm256_mul_pd(t_im, d_im)), dc_re);
+            __m256d new_im = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(t_re, d_im), _mm256_mul_pd(t_im, d_re)), dc_im);
+            d_re = new_re;
+            d_im = new_im;
+            m = _mm256_sub_epi64(m, _mm256_castpd_si256(active));
+
+            __m256d z_re = _mm256_add_pd(_mm256_i64gather_pd(ref_re, m, 8), d_re);
+            __m256d z_im = _mm256_add_pd(_mm256_i64gather_pd(ref_im, m, 8), d_im);
+            __m256d z2 = _mm256_add_pd(_mm256_mul_pd(z_re, z_re), _mm256_mul_pd(z_im, z_im));
+            active = _mm256_andnot_pd(_mm256_cmp_pd(z2, four, _CMP_GT_OQ), active);
+            if (_mm256_movemask_pd(active) == 0)
+                break;
+            count = _mm256_sub_epi64(count, _mm256_castpd_si256(active));
+
+            __m256d d2 = _mm256_add_pd(_mm256_mul_pd(d_re, d_re), _mm256_mul_pd(d_im, d_im));
+            __m256d rebase = _mm256_or_pd(_mm256_cmp_pd(z2, d2, _CMP_LT_OQ),
+                                          _mm256_castsi256_pd(_mm256_cmpeq_epi64(m, last)));
+            rebase = _mm256_and_pd(rebase, active);
+            d_re = _mm256_blendv_pd(d_re, z_re, rebase);
+            d_im = _mm256_blendv_pd(d_im, z_im, rebase);
+            m = _mm256_andnot_si256(_mm256_castpd_si256(rebase), m);
+        }
+
+        long long counts[4];
+        _mm256_storeu_si256((__m256i*)counts, count);
+        for (int k = 0; k < 4; ++k)
+            output[i - startCol + k] = (int)counts[k];
+    }
+    return i - startCol;
+}
+
+// The unmasked gather leaves its pass-through operand undefined, which
+// GCC 12 reports as uninitialized; all lanes are loaded either way.
+__attribute__((target("avx512f")))
+static inline __m512d gatherAVX512(const double* base, __m512i index)
+{
+    return _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, index, base, 8);
+}
+
+__attribute__((target("avx512f")))
+static int deepRowAVX512(const DeepFrame& frame, int j, int startCol, int endCol, int maxIterations, int output[])
+{
+    const double* ref_re = frame.refRe.data();
+    const double* ref_im = frame.refIm.data();
+    const __m512d four = _mm512_set1_pd(4.0);
+    const __m512d two = _mm512_set1_pd(2.0);
+    const __m512d pixel = _mm512_set1_pd(frame.pixelSize);
+    const __m512d vdx0 = _mm512_set1_pd(frame.deltaX0);
+    const __m512d lane = _mm512_setr_pd(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m512i one = _mm512_set1_epi64(1);
+    const __m512i last = _mm512_set1_epi64(frame.refLength);
+
+    int i = startCol;
+    for (; i + 8 <= endCol; i += 8) {
+        __m512d dc_re = _mm512_add_pd(vdx0, _mm512_mul_pd(_mm512_add_pd(_mm512_set1_pd((double)i), lane), pixel));
+        __m512d dc_im = _mm512_set1_pd(frame.deltaY0 + j * frame.pixelSize);
+        __m512d d_re = _mm512_setzero_pd(), d_im = _mm512_setzero_pd();
+        __m512i m = _mm512_setzero_si512();
+        __mmask8 active = 0xFF;
+        __m512i count = _mm512_setzero_si512();
+
+        for (int it = 0; it < maxIterations; ++it) {
+            __m512d t_re = _mm512_add_pd(_mm512_mul_pd(two, gatherAVX512(ref_re, m)), d_re);
+            __m512d t_im = _mm512_add_pd(_mm512_mul_pd(two, gatherAVX512(ref_im, m)), d_im);
+            __m512d new_re = _mm512_add_pd(_mm512_sub_pd(_mm512_mul_pd(t_re, d_re), _mm512_mul_pd(t_im, d_im)), dc_re);
+            __m512d new_im = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(t_re, d_im), _mm512_mul_pd(t_im, d_re)), dc_im);
+            d_re = new_re;
+            d_im = new_im;
+            m = _mm512_mask_add_epi64(m, active, m, one);
+
+            __m512d z_re = _mm512_add_pd(gatherAVX512(ref_re, m), d_re);
+            __m512d z_im = _mm512_add_pd(gatherAVX512(ref_im, m), d_im);
+            __m512d z2 = _mm512_add_pd(_mm512_mul_pd(z_re, z_re), _mm512_mul_pd(z_im, z_im));
+            active = _mm512_mask_cmp_pd_mask(active, z2, four, _CMP_NGT_UQ);
+            if (active == 0)
+                break;
+            count = _mm512_mask_add_epi64(count, active, count, one);
+
+            __m512d d2 = _mm512_add_pd(_mm512_mul_pd(d_re, d_re), _mm512_mul_pd(d_im, d_im));
+            __mmask8 rebase = _mm512_mask_cmp_pd_mask(active, z2, d2, _CMP_LT_OQ) |
+                              _mm512_mask_cmpeq_epi64_mask(active, m, last);
+            d_re = _mm512_mask_mov_pd(d_re, rebase, z_re);
+            d_im = _mm512_mask_mov_pd(d_im, rebase, z_im);
+            m = _mm512_mask_mov_epi64(m, rebase, _mm512_setzero_si512());
+        }
+
+        _mm256_storeu_si256((__m256i*)(output + (i - startCol)), _mm512_mask_cvtepi64_epi32(_mm256_setzero_si256(), 0xFF, count));
+    }
+    return i - startCol;
+}
+
+int deepRowSimd(SimdLevel level, const DeepFrame& frame,
+                int j, int startCol, int endCol, int maxIterations,
+                int output[])
+{
+    switch (level) {
+    case SIMD_AVX2:   return deepRowAVX2(frame, j, startCol, endCol, maxIterations, output);
+    case SIMD_AVX512: return deepRowAVX512(frame, j, startCol, endCol, maxIterations, output);
+    default:          return 0;
+    }
+}
+
+#else
+
+SimdLevel resolveSimdLevel(SimdLevel)
+{
+    return SIMD_NONE;
+}
+
+int mandelRowSimd(SimdLevel, float, float, float, int, int, int, int[])
+{
+    return 0;
+}
+
+int deepRowSimd(SimdLevel, const DeepFrame&, int, int, int, int, int[])
+{
+    return 0;
+}
+
+#endif // MANDEL_SIMD_X86
@@ -0,0 +1,55 @@
+#ifndef _MANDELBROT_SIMD_H_
+#define _MANDELBROT_SIMD_H_
+
+#include "deepZoom.h"
+
+//
+// Instruction set used by the vectorized mandel() row kernel.
+//
+// * SIMD_NONE    scalar mandel(), one pixel at a time
+// * SIMD_SSE     4 pixels per iteration (SSE2)
+// * SIMD_AVX2    8 pixels per iteration
+// * SIMD_AVX512  16 pixels per iteration (AVX-512F)
+// * SIMD_AUTO    widest of the above that the running CPU supports
+enum SimdLevel {
+    SIMD_NONE,
+    SIMD_SSE,
+    SIMD_AVX2,
+    SIMD_AVX512,
+    SIMD_AUTO
+};
+
+bool parseSimdLevel(const char* name, SimdLevel* level);
+const char* simdLevelName(SimdLevel level);
+
+// Map SIMD_AUTO to the best supported level, and downgrade an explicit
+// request the CPU cannot execute to the best level it can.
+SimdLevel resolveSimdLevel(SimdLevel requested);
+
+//
+// mandelRowSimd --
+//
+// For columns i in [startCol, endCol) of one row, compute
+// output[i - startCol] = mandel(x0 + i * dx, y, maxIterations) for as
+// many leading pixels as fill whole vectors, with per-lane early exit.
+// Uses exactly the float operations of the scalar kernel (no FMA), so
+// results are bit-identical.  Returns the number of pixels written; the
+// caller finishes the remaining ones.  level must already be resolved.
+int mandelRowSimd(SimdLevel level,
+                  float x0, float dx, float y,
+                  int startCol, int endCol, int maxIterations,
+                  int output[]);
+
+//
+// deepRowSimd --
+//
+// Perturbation counterpart of mandelRowSimd: for columns of row j,
+// output[i - startCol] = deepPixel(frame, dc(i), dc(j), maxIterations),
+// in double lanes (4 for AVX2, 8 for AVX-512) with per-lane reference
+// indices fetched by gather.  Bit-identical to deepPixel.  SSE has no
+// gather and writes nothing.  Returns the number of pixels written.
+int deepRowSimd(SimdLevel level, const DeepFrame& frame,
+                int j, int startCol, int endCol, int maxIterations,
+                int output[]);
+
+#endif // _MANDELBROT_SIMD_H_
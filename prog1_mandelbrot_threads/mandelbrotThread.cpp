@@ -1,7 +1,42 @@
+#include <math.h>
 #include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include "CycleTimer.h"
+#include "tileLayout.h"
+#include "progressive.h"
+#include "WorkerPool.h"
+#include "mandelbrotSimd.h"
+#include "mandelbrotThread.h"
+
+// Rows handed out at a time by the dynamic and work-stealing schedules.
+static constexpr int ROWS_PER_CHUNK = 4;
+
+//
+// ChunkDeque --
+//
+// Range [head, tail) of chunks (row blocks or tiles) owned by one thread.  The owner pops
+// from the head; thieves take the back half from the tail.  Padded by a
+// cache line so neighbouring deques in an array do not false-share.
+struct ChunkDeque {
+    std::mutex lock;
+    int head;
+    int tail;
+    char padding[64];
+};
+
+// State shared by all workers of one call.
+typedef struct {
+    std::atomic<int> nextChunk;
+    ChunkDeque* deques;
+    int numChunks;
+} SharedSchedule;
 
 typedef struct {
     float x0, x1;
@@ -12,6 +47,14 @@ typedef struct {
     int* output;
     int threadId;
     int numThreads;
+    ScheduleMode schedule;
+    SharedSchedule* shared;
+    bool tiled;
+    bool tiledLayout;
+    bool mariani;
+    const DeepFrame* deep;
+    TileLayout tiles;
+    double busySeconds;
 } WorkerArgs;
 
 
@@ -22,6 +65,13 @@ extern void mandelbrotSerial(
     int maxIterations,
     int output[]);
 
+extern void mandelbrotRectMariani(
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int rectX, int rectY, int rectW, int rectH,
+    int maxIterations,
+    int out[], int stride);
+
 static inline int mandel(float c_re, float c_im, int count)
 {
     float z_re = c_re, z_im = c_im;
@@ -40,56 +90,379 @@ static inline int mandel(float c_re, float c_im, int count)
     return i;
 }
 
+// Points this far inside the main cardioid or the period-2 bulb (in
+// units of c) are reported as members without iterating.  The margin
+// keeps the analytic test away from the boundary, where the float
+// orbit of a member can still escape.
+static const double EARLY_OUT_MARGIN = 1e-3;
+
+static inline bool inCardioidOrBulb(float c_re, float c_im)
+{
+    double x = c_re, y = c_im;
+
+    double xq = x - 0.25;
+    double p = sqrt(xq * xq + y * y);
+    if (x < p - 2.0 * p * p + 0.25 - EARLY_OUT_MARGIN)
+        return true;
+
+    double r = 0.25 - EARLY_OUT_MARGIN;
+    return (x + 1.0) * (x + 1.0) + y * y < r * r;
+}
+
 //
-// workerThreadStart --
+// mandelEarlyOut --
 //
-// Thread entrypoint.
-// 每个线程应该做的事情，这里目前没有实现
-void workerThreadStart(WorkerArgs * const args) {
+// Same result as mandel(), with two shortcuts for points in the set.
+// Points well inside the main cardioid or period-2 bulb return count
+// immediately.  Otherwise the orbit is compared against a saved point
+// that is refreshed at iterations 1, 2, 4, 8, ... (Brent's cycle
+// detection).  An exact repeat of a float state means the float
+// iteration has entered a cycle and can never escape, so the result is
+// count without running the remaining iterations.
+static inline int mandelEarlyOut(float c_re, float c_im, int count)
+{
+    if (inCardioidOrBulb(c_re, c_im))
+        return count;
+
+    float z_re = c_re, z_im = c_im;
+    float saved_re = z_re, saved_im = z_im;
+    int checkpoint = 1;
+    int i;
+    for (i = 0; i < count; ++i) {
+
+        if (z_re * z_re + z_im * z_im > 4.f)
+            break;
+
+        float new_re = z_re*z_re - z_im*z_im;
+        float new_im = 2.f * z_re * z_im;
+        z_re = c_re + new_re;
+        z_im = c_im + new_im;
+
+        if (z_re == saved_re && z_im == saved_im)
+            return count;
+        if (i + 1 == checkpoint) {
+            saved_re = z_re;
+            saved_im = z_im;
+            checkpoint *= 2;
+        }
+    }
+
+    return i;
+}
+
+// Row kernel used by all workers, already resolved against the CPU.
+static SimdLevel simdLevel = SIMD_NONE;
+
+void setSimdLevel(SimdLevel level)
+{
+    simdLevel = resolveSimdLevel(level);
+}
+
+SimdLevel getSimdLevel()
+{
+    return simdLevel;
+}
+
+// Cardioid/bulb test and periodicity checking for every pixel.
+static bool earlyOut = false;
+
+void setEarlyOut(bool enabled)
+{
+    earlyOut = enabled;
+}
+
+// Tile decomposition used by all workers; tileWidth 0 means rows.
+static int tileWidth = 0;
+static int tileHeight = 0;
+static bool tiledLayout = false;
+
+void setTiling(int width, int height, bool layout)
+{
+    tileWidth = width;
+    tileHeight = height;
+    tiledLayout = layout;
+}
+
+// Mariani-Silver subdivision works on rectangles, so when it is enabled
+// without an explicit tiling the image is split into tiles of this size.
+static constexpr int MARIANI_TILE_SIZE = 64;
+static bool marianiSilver = false;
+
+void setMarianiSilver(bool enabled)
+{
+    marianiSilver = enabled;
+}
+
+//
+// renderSpan --
+//
+// Compute columns [startCol, endCol) of row j into out[0 .. endCol-startCol).
+// The SIMD kernel covers whole vectors and the scalar loop finishes the
+// remainder.  The early-out kernel is scalar only.
+static void renderSpan(const WorkerArgs* args, int j, int startCol, int endCol, int* out) {
+
+    if (args->deep) {
+        const DeepFrame& frame = *args->deep;
+        int i = startCol;
+        if (simdLevel != SIMD_NONE)
+            i += deepRowSimd(simdLevel, frame, j, startCol, endCol, args->maxIterations, out);
+        for (; i < endCol; ++i) {
+            double dc_re = frame.deltaX0 + i * frame.pixelSize;
+            double dc_im = frame.deltaY0 + j * frame.pixelSize;
+
+            out[i - startCol] = deepPixel(frame, dc_re, dc_im, args->maxIterations);
+        }
+        return;
+    }
 
-    // 只要把任务切得细一点，交叉分配就可以了
     float dx = (args->x1 - args->x0) / args->width;
     float dy = (args->y1 - args->y0) / args->height;
 
-    for (int j = args->threadId; j < args->height; j += args->numThreads) {
-        for (int i = 0; i < args->width; ++i) {
+    if (earlyOut) {
+        for (int i = startCol; i < endCol; ++i) {
             float x = args->x0 + i * dx;
             float y = args->y0 + j * dy;
 
-            int index = (j * args->width + i);
-
-            args->output[index] = mandel(x, y, args->maxIterations);
+            out[i - startCol] = mandelEarlyOut(x, y, args->maxIterations);
         }
+        return;
     }
 
-    printf("Hello world from thread %d\n", args->threadId);
+    int i = startCol;
+    if (simdLevel != SIMD_NONE) {
+        i += mandelRowSimd(simdLevel, args->x0, dx, args->y0 + j * dy,
+                           startCol, endCol, args->maxIterations, out);
+    }
+    for (; i < endCol; ++i) {
+        float x = args->x0 + i * dx;
+        float y = args->y0 + j * dy;
 
+        out[i - startCol] = mandel(x, y, args->maxIterations);
+    }
 }
 
 //
-// MandelbrotThread --
+// renderRows --
 //
-// Multi-threaded implementation of mandelbrot set image generation.
-// Threads of execution are created by spawning std::threads.
-void mandelbrotThread(
-    int numThreads,
+// Compute rows [startRow, endRow) of the image described by args.
+static void renderRows(const WorkerArgs* args, int startRow, int endRow) {
+
+    for (int j = startRow; j < endRow; j++)
+        renderSpan(args, j, 0, args->width, args->output + (size_t)j * args->width);
+}
+
+//
+// renderTile --
+//
+// Compute one tile.  In the tiled layout the tile's rows are packed
+// back to back, otherwise they land in their usual image rows.
+static void renderTile(const WorkerArgs* args, int tile) {
+
+    int x, y, w, h;
+    args->tiles.tileRect(tile, &x, &y, &w, &h);
+
+    if (args->mariani) {
+        if (args->tiledLayout)
+            mandelbrotRectMariani(args->x0, args->y0, args->x1, args->y1,
+                                  args->width, args->height, x, y, w, h, args->maxIterations,
+                                  args->output + args->tiles.tileOffset(tile), w);
+        else
+            mandelbrotRectMariani(args->x0, args->y0, args->x1, args->y1,
+                                  args->width, args->height, x, y, w, h, args->maxIterations,
+                                  args->output + (size_t)y * args->width + x, args->width);
+        return;
+    }
+
+    for (int j = 0; j < h; j++) {
+        int* out = args->tiledLayout
+            ? args->output + args->tiles.tileOffset(tile) + (size_t)j * w
+            : args->output + (size_t)(y + j) * args->width + x;
+        renderSpan(args, y + j, x, x + w, out);
+    }
+}
+
+static void renderChunk(const WorkerArgs* args, int chunk) {
+    if (args->tiled) {
+        renderTile(args, chunk);
+        return;
+    }
+    int startRow = chunk * ROWS_PER_CHUNK;
+    int endRow = std::min(startRow + ROWS_PER_CHUNK, (int)args->height);
+    renderRows(args, startRow, endRow);
+}
+
+//
+// stealChunks --
+//
+// Move the back half of some other thread's deque into the (empty)
+// deque of args->threadId.  Returns false once every victim is empty,
+// which means all remaining chunks are already owned by threads that
+// will finish them.
+static bool stealChunks(WorkerArgs* const args) {
+    ChunkDeque* deques = args->shared->deques;
+
+    for (int k = 1; k < args->numThreads; k++) {
+        ChunkDeque& victim = deques[(args->threadId + k) % args->numThreads];
+        int begin, end;
+        {
+            std::lock_guard<std::mutex> guard(victim.lock);
+            int available = victim.tail - victim.head;
+            if (available <= 0)
+                continue;
+            end = victim.tail;
+            begin = end - (available + 1) / 2;
+            victim.tail = begin;
+        }
+
+        ChunkDeque& self = deques[args->threadId];
+        std::lock_guard<std::mutex> guard(self.lock);
+        self.head = begin;
+        self.tail = end;
+        return true;
+    }
+    return false;
+}
+
+//
+// workerThreadStart --
+//
+// Thread entrypoint.  Computes this thread's share of the rows, or of
+// the tiles when tiling is enabled, according to args->schedule.
+void workerThreadStart(WorkerArgs * const args) {
+
+    double startTime = CycleTimer::currentSeconds();
+    int height = args->height;
+    int numChunks = args->shared->numChunks;
+
+    switch (args->schedule) {
+    case SCHED_STATIC:
+    {
+        if (args->tiled) {
+            int begin = (int)((long long)numChunks * args->threadId / args->numThreads);
+            int end = (int)((long long)numChunks * (args->threadId + 1) / args->numThreads);
+            for (int tile = begin; tile < end; tile++)
+                renderTile(args, tile);
+            break;
+        }
+        int rowsPerThread = height / args->numThreads;
+        int startRow = args->threadId * rowsPerThread;
+        int endRow = (args->threadId == args->numThreads - 1) ? height : startRow + rowsPerThread;
+        renderRows(args, startRow, endRow);
+        break;
+    }
+    case SCHED_INTERLEAVED:
+    {
+        if (args->tiled) {
+            for (int tile = args->threadId; tile < numChunks; tile += args->numThreads)
+                renderTile(args, tile);
+            break;
+        }
+        // 只要把任务切得细一点，交叉分配就可以了
+        for (int j = args->threadId; j < height; j += args->numThreads)
+            renderRows(args, j, j + 1);
+        break;
+    }
+    case SCHED_DYNAMIC:
+    {
+        int chunk;
+        while ((chunk = args->shared->nextChunk.fetch_add(1)) < numChunks)
+            renderChunk(args, chunk);
+        break;
+    }
+    case SCHED_STEAL:
+    {
+        ChunkDeque& self = args->shared->deques[args->threadId];
+        for (;;) {
+            int chunk = -1;
+            {
+                std::lock_guard<std::mutex> guard(self.lock);
+                if (self.head < self.tail)
+                    chunk = self.head++;
+            }
+            if (chunk >= 0)
+                renderChunk(args, chunk);
+            else if (!stealChunks(args))
+                break;
+        }
+        break;
+    }
+    }
+
+    args->busySeconds = CycleTimer::currentSeconds() - startTime;
+}
+
+bool parseScheduleMode(const char* name, ScheduleMode* mode)
+{
+    static const ScheduleMode modes[] = { SCHED_STATIC, SCHED_INTERLEAVED, SCHED_DYNAMIC, SCHED_STEAL };
+    for (unsigned int i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (strcmp(name, scheduleModeName(modes[i])) == 0) {
+            *mode = modes[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* scheduleModeName(ScheduleMode mode)
+{
+    switch (mode) {
+    case SCHED_STATIC:      return "static";
+    case SCHED_INTERLEAVED: return "interleaved";
+    case SCHED_DYNAMIC:     return "dynamic";
+    case SCHED_STEAL:       return "steal";
+    }
+    return "unknown";
+}
+
+// CPU placement applied to threads created from now on.
+static PinPolicy pinPolicy = PIN_NONE;
+
+void setThreadPlacement(PinPolicy policy)
+{
+    pinPolicy = policy;
+}
+
+// A non-positive thread count means "one per hardware thread".
+static int resolveNumThreads(int numThreads)
+{
+    return numThreads > 0 ? numThreads : defaultThreadCount();
+}
+
+// The calling thread works as thread 0, so it takes cpus[0]; with no
+// placement it gets its original mask back if an earlier call pinned it.
+static void pinCallingThread(const std::vector<int>& cpus)
+{
+    static bool pinned = false;
+    if (!cpus.empty())
+        pinned = pinCurrentThread(cpus[0]);
+    else if (pinned)
+        pinned = !unpinCurrentThread();
+}
+
+static void initWorkerArgs(
+    WorkerArgs args[], int numThreads,
     float x0, float y0, float x1, float y1,
     int width, int height,
-    int maxIterations, int output[])
+    int maxIterations, int output[],
+    ScheduleMode schedule, SharedSchedule* shared, ChunkDeque deques[])
 {
-    static constexpr int MAX_THREADS = 32;
-
-    // 查看使用线程数是否超过最大限制
-    if (numThreads > MAX_THREADS)
-    {
-        fprintf(stderr, "Error: Max allowed threads is %d\n", MAX_THREADS);
-        exit(1);
+    TileLayout tiles = { width, height, tileWidth, tileHeight };
+    bool tiled = tileWidth > 0 && tileHeight > 0;
+    if (marianiSilver && !tiled) {
+        tiles.tileWidth = tiles.tileHeight = MARIANI_TILE_SIZE;
+        tiled = true;
     }
 
-    // 创建线程对象，但目前还没有线程实例
-    // Creates thread objects that do not yet represent a thread.
-    std::thread workers[MAX_THREADS];
-    WorkerArgs args[MAX_THREADS];
+    // Split the chunk range evenly over the per-thread deques; the
+    // dynamic schedule instead starts everyone on the shared counter.
+    int numChunks = tiled ? tiles.numTiles() : (height + ROWS_PER_CHUNK - 1) / ROWS_PER_CHUNK;
+    shared->nextChunk = 0;
+    shared->deques = deques;
+    shared->numChunks = numChunks;
+    for (int i=0; i<numThreads; i++) {
+        deques[i].head = (int)((long long)numChunks * i / numThreads);
+        deques[i].tail = (int)((long long)numChunks * (i + 1) / numThreads);
+    }
 
     // 初始化所有线程的参数
     for (int i=0; i<numThreads; i++) {
@@ -106,19 +479,69 @@ void mandelbrotThread(
         args[i].maxIterations = maxIterations;
         args[i].numThreads = numThreads;
         args[i].output = output;
+        args[i].schedule = schedule;
+        args[i].shared = shared;
+        args[i].tiled = tiled;
+        args[i].tiledLayout = tiled && tiledLayout;
+        args[i].mariani = marianiSilver;
+        args[i].deep = NULL;
+        args[i].tiles = tiles;
+        args[i].busySeconds = 0.0;
       
         args[i].threadId = i;
     }
+}
+
+static void collectBusySeconds(const WorkerArgs args[], int numThreads, double busySeconds[])
+{
+    if (busySeconds == NULL)
+        return;
+    for (int i=0; i<numThreads; i++)
+        busySeconds[i] = args[i].busySeconds;
+}
+
+//
+// MandelbrotThreadSpawn --
+//
+// Multi-threaded implementation of mandelbrot set image generation.
+// Threads of execution are created by spawning std::threads on every
+// call and joined before returning.
+void mandelbrotThreadSpawn(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations, int output[],
+    ScheduleMode schedule, double busySeconds[])
+{
+    numThreads = resolveNumThreads(numThreads);
+    std::vector<int> cpus = placementCpus(pinPolicy, numThreads);
+
+    // 创建线程对象，但目前还没有线程实例
+    // Creates thread objects that do not yet represent a thread.
+    std::vector<std::thread> workers(numThreads);
+    std::vector<WorkerArgs> args(numThreads);
+    SharedSchedule shared;
+    std::vector<ChunkDeque> deques(numThreads);
+
+    initWorkerArgs(args.data(), numThreads, x0, y0, x1, y1, width, height, maxIterations, output,
+                   schedule, &shared, deques.data());
 
     // 启动所有线程，除了线程0，每个线程都使用 args[i] 参数去执行函数 workerThreadStart
     // Spawn the worker threads.  Note that only numThreads-1 std::threads
     // are created and the main application thread is used as a worker
     // as well.
     for (int i=1; i<numThreads; i++) {
-        workers[i] = std::thread(workerThreadStart, &args[i]);
+        WorkerArgs* workerArgs = &args[i];
+        int cpu = cpus.empty() ? -1 : cpus[i];
+        workers[i] = std::thread([workerArgs, cpu] {
+            if (cpu >= 0)
+                pinCurrentThread(cpu);
+            workerThreadStart(workerArgs);
+        });
     }
     
     // 线程0也执行 workerThreadStart
+    pinCallingThread(cpus);
     workerThreadStart(&args[0]);
 
     // 等待所有线程结束
@@ -126,5 +549,327 @@ void mandelbrotThread(
     for (int i=1; i<numThreads; i++) {
         workers[i].join();
     }
+
+    collectBusySeconds(args.data(), numThreads, busySeconds);
+}
+
+//
+// getWorkerPool --
+//
+// Return the process-wide worker pool, (re)creating it on first use,
+// when more threads are requested than it currently holds, or when the
+// placement policy changed.  The pool lives until program exit so
+// consecutive frames reuse parked threads.
+static WorkerPool* getWorkerPool(int numThreads)
+{
+    static WorkerPool* pool = NULL;
+    static PinPolicy poolPolicy = PIN_NONE;
+    if (pool == NULL || pool->size() < numThreads || poolPolicy != pinPolicy) {
+        delete pool;
+        pool = new WorkerPool(numThreads, placementCpus(pinPolicy, numThreads));
+        poolPolicy = pinPolicy;
+        pinCallingThread(pool->cpus());
+    }
+    return pool;
+}
+
+//
+// MandelbrotThread --
+//
+// Multi-threaded implementation of mandelbrot set image generation.
+// Row blocks are dispatched to a persistent pool of worker threads
+// that stay parked between calls, so per-frame cost excludes thread
+// creation and join.
+void mandelbrotThread(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations, int output[],
+    ScheduleMode schedule, double busySeconds[])
+{
+    numThreads = resolveNumThreads(numThreads);
+
+    std::vector<WorkerArgs> args(numThreads);
+    SharedSchedule shared;
+    std::vector<ChunkDeque> deques(numThreads);
+
+    initWorkerArgs(args.data(), numThreads, x0, y0, x1, y1, width, height, maxIterations, output,
+                   schedule, &shared, deques.data());
+
+    getWorkerPool(numThreads)->run(numThreads, [&args](int threadId) {
+        workerThreadStart(&args[threadId]);
+    });
+
+    collectBusySeconds(args.data(), numThreads, busySeconds);
+}
+
+//
+// MandelbrotThreadDeep --
+//
+// Render a deep-zoom frame (see common/deepZoom.h) with the worker
+// pool, using the current schedule, tiling and SIMD settings.  The
+// early-out and Mariani-Silver options do not apply.
+void mandelbrotThreadDeep(
+    int numThreads,
+    const DeepFrame& frame,
+    int maxIterations, int output[],
+    ScheduleMode schedule, double busySeconds[])
+{
+    numThreads = resolveNumThreads(numThreads);
+
+    std::vector<WorkerArgs> args(numThreads);
+    SharedSchedule shared;
+    std::vector<ChunkDeque> deques(numThreads);
+
+    initWorkerArgs(args.data(), numThreads, 0.f, 0.f, 0.f, 0.f, frame.width, frame.height,
+                   maxIterations, output, schedule, &shared, deques.data());
+    for (int i=0; i<numThreads; i++) {
+        args[i].deep = &frame;
+        args[i].mariani = false;
+    }
+
+    getWorkerPool(numThreads)->run(numThreads, [&args](int threadId) {
+        workerThreadStart(&args[threadId]);
+    });
+
+    collectBusySeconds(args.data(), numThreads, busySeconds);
+}
+
+//
+// BandStream --
+//
+// Bounded reorder buffer shared by the workers of one streamed render.
+// Band b is rendered into slot b % capacity, and is only started once
+// fewer than capacity bands are waiting to be written, so memory stays
+// at capacity bands however tall the image is.  Whichever thread
+// completes the oldest unwritten band hands it, and any bands already
+// finished behind it, to the sink in order.
+struct BandStream {
+    std::mutex lock;
+    std::condition_variable slotFree;
+    int numBands;
+    int bandRows;
+    int capacity;
+    int nextBand;       // next band to render
+    int nextToWrite;    // next band to pass to the sink
+    bool writing;       // some thread is inside the sink
+    std::vector<std::vector<int> > slots;
+    std::vector<char> ready;
+};
+
+static void streamBands(const WorkerArgs* args, BandStream* stream, const BandSink& sink)
+{
+    int width = args->width;
+    int height = args->height;
+
+    std::unique_lock<std::mutex> guard(stream->lock);
+    for (;;) {
+        stream->slotFree.wait(guard, [stream] {
+            return stream->nextBand >= stream->numBands ||
+                   stream->nextBand < stream->nextToWrite + stream->capacity;
+        });
+        if (stream->nextBand >= stream->numBands)
+            break;
+        int band = stream->nextBand++;
+        int* slot = stream->slots[band % stream->capacity].data();
+        guard.unlock();
+
+        int startRow = band * stream->bandRows;
+        int endRow = std::min(startRow + stream->bandRows, height);
+        for (int j = startRow; j < endRow; j++)
+            renderSpan(args, j, 0, width, slot + (size_t)(j - startRow) * width);
+
+        guard.lock();
+        stream->ready[band % stream->capacity] = 1;
+        while (!stream->writing && stream->nextToWrite < stream->numBands &&
+               stream->ready[stream->nextToWrite % stream->capacity]) {
+            int next = stream->nextToWrite;
+            int nextRow = next * stream->bandRows;
+            int numRows = std::min(stream->bandRows, height - nextRow);
+            stream->writing = true;
+            guard.unlock();
+
+            sink(stream->slots[next % stream->capacity].data(), nextRow, numRows);
+
+            guard.lock();
+            stream->ready[next % stream->capacity] = 0;
+            stream->nextToWrite++;
+            stream->writing = false;
+            stream->slotFree.notify_all();
+        }
+    }
+}
+
+//
+// MandelbrotThreadStream --
+//
+// Render the image band by band without ever holding all of it: the
+// worker pool renders bands of bandRows rows in parallel, and the
+// finished bands are passed to sink in top-to-bottom order.  At most
+// 2 * numThreads bands are buffered at any time; returns the number of
+// band buffers used.
+int mandelbrotThreadStream(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations,
+    int bandRows,
+    const BandSink& sink)
+{
+    numThreads = resolveNumThreads(numThreads);
+
+    WorkerArgs args = WorkerArgs();
+    args.x0 = x0;
+    args.y0 = y0;
+    args.x1 = x1;
+    args.y1 = y1;
+    args.width = width;
+    args.height = height;
+    args.maxIterations = maxIterations;
+    args.deep = NULL;
+
+    BandStream stream;
+    stream.numBands = (height + bandRows - 1) / bandRows;
+    stream.bandRows = bandRows;
+    stream.capacity = std::min(2 * numThreads, stream.numBands);
+    stream.nextBand = 0;
+    stream.nextToWrite = 0;
+    stream.writing = false;
+    stream.slots.assign(stream.capacity, std::vector<int>((size_t)bandRows * width));
+    stream.ready.assign(stream.capacity, 0);
+
+    getWorkerPool(numThreads)->run(numThreads, [&](int) {
+        streamBands(&args, &stream, sink);
+    });
+
+    return stream.capacity;
+}
+
+//
+// renderPassRow --
+//
+// Compute the pixels of row j that belong to the progressive pass with
+// the given step, painting each over its step x step block.  Rows of
+// the full resolution pass that are not shared with the 1/2 pass need
+// every pixel, and go through renderSpan so the SIMD kernels apply.
+static void renderPassRow(const WorkerArgs* args, int j, int step) {
+
+    int width = args->width;
+    int first, stride;
+    progressivePassColumns(j, step, &first, &stride);
+    if (stride == 1) {
+        renderSpan(args, j, 0, width, args->output + (size_t)j * width);
+        return;
+    }
+
+    float dx = (args->x1 - args->x0) / args->width;
+    float dy = (args->y1 - args->y0) / args->height;
+    for (int i = first; i < width; i += stride) {
+        float x = args->x0 + i * dx;
+        float y = args->y0 + j * dy;
+
+        int value = earlyOut ? mandelEarlyOut(x, y, args->maxIterations)
+                             : mandel(x, y, args->maxIterations);
+        fillProgressiveBlock(args->output, width, args->height, i, j, step, value);
+    }
+}
+
+//
+// MandelbrotThreadPass --
+//
+// Compute one progressive pass (see common/progressive.h) with the
+// worker pool.  Workers pull chunks of the pass's rows from a shared
+// counter and stop early once cancel is set.  Returns false if the pass
+// was cancelled.
+bool mandelbrotThreadPass(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations,
+    int step,
+    int output[],
+    const CancelToken* cancel)
+{
+    numThreads = resolveNumThreads(numThreads);
+
+    WorkerArgs args = WorkerArgs();
+    args.x0 = x0;
+    args.y0 = y0;
+    args.x1 = x1;
+    args.y1 = y1;
+    args.width = width;
+    args.height = height;
+    args.maxIterations = maxIterations;
+    args.output = output;
+    args.deep = NULL;
+
+    // rows of this pass are 0, step, 2 * step, ...
+    int numRows = (height + step - 1) / step;
+    std::atomic<int> nextRow(0);
+
+    getWorkerPool(numThreads)->run(numThreads, [&](int) {
+        int row;
+        while ((row = nextRow.fetch_add(ROWS_PER_CHUNK)) < numRows) {
+            if (cancel && cancel->cancelled())
+                return;
+            int endRow = std::min(row + ROWS_PER_CHUNK, numRows);
+            for (int r = row; r < endRow; r++)
+                renderPassRow(&args, r * step, step);
+        }
+    });
+
+    return !(cancel && cancel->cancelled());
 }
 
+//
+// MandelbrotThreadRects --
+//
+// Compute rectangles of a frame placed at (colOffset, rowOffset) on the
+// pixel grid of viewport (x0, y0, x1, y1) at width x height (see
+// common/panCache.h).  Rows of all rectangles are handed out in chunks
+// from a shared counter, so thin strips still spread over every thread.
+void mandelbrotThreadRects(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations,
+    int colOffset, int rowOffset,
+    const PanRect rects[], int numRects,
+    int output[])
+{
+    numThreads = resolveNumThreads(numThreads);
+
+    WorkerArgs args = WorkerArgs();
+    args.x0 = x0;
+    args.y0 = y0;
+    args.x1 = x1;
+    args.y1 = y1;
+    args.width = width;
+    args.height = height;
+    args.maxIterations = maxIterations;
+    args.output = output;
+    args.deep = NULL;
+
+    // (rect, first row) of every chunk
+    std::vector<std::pair<int, int>> chunks;
+    for (int r = 0; r < numRects; r++)
+        for (int row = 0; row < rects[r].height; row += ROWS_PER_CHUNK)
+            chunks.push_back(std::make_pair(r, row));
+
+    std::atomic<int> nextChunk(0);
+    int numChunks = (int)chunks.size();
+
+    getWorkerPool(numThreads)->run(numThreads, [&](int) {
+        int chunk;
+        while ((chunk = nextChunk.fetch_add(1)) < numChunks) {
+            const PanRect& rect = rects[chunks[chunk].first];
+            int endRow = std::min(chunks[chunk].second + ROWS_PER_CHUNK, rect.height);
+            for (int row = chunks[chunk].second; row < endRow; row++) {
+                int j = rect.y + row;
+                renderSpan(&args, rowOffset + j, colOffset + rect.x,
+                           colOffset + rect.x + rect.width,
+                           output + (size_t)j * width + rect.x);
+            }
+        }
+    });
+}
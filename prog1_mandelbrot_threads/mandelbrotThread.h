@@ -0,0 +1,129 @@
+#ifndef _MANDELBROT_THREAD_H_
+#define _MANDELBROT_THREAD_H_
+
+#include <functional>
+
+#include "mandelbrotSimd.h"
+#include "panCache.h"
+#include "progressive.h"
+#include "threadPlacement.h"
+
+//
+// How rows of the image are distributed over worker threads.
+//
+// * SCHED_STATIC       one contiguous block of rows per thread
+// * SCHED_INTERLEAVED  thread t computes rows t, t+numThreads, ...
+// * SCHED_DYNAMIC      threads pull small row chunks from a shared counter
+// * SCHED_STEAL        each thread owns a deque of row chunks and steals
+//                      from the back of other threads' deques when idle
+enum ScheduleMode {
+    SCHED_STATIC,
+    SCHED_INTERLEAVED,
+    SCHED_DYNAMIC,
+    SCHED_STEAL
+};
+
+// Parse "static", "interleaved", "dynamic" or "steal".  Returns false
+// if name is not a known schedule.
+bool parseScheduleMode(const char* name, ScheduleMode* mode);
+const char* scheduleModeName(ScheduleMode mode);
+
+// Pin worker threads created after this call according to policy.  The
+// calling thread doubles as worker 0 and is pinned as well.
+void setThreadPlacement(PinPolicy policy);
+
+// Select the per-row kernel (scalar or SIMD) used by every worker.
+// Requests the CPU cannot execute fall back to the best level it can.
+void setSimdLevel(SimdLevel level);
+SimdLevel getSimdLevel();
+
+// Split the image into tileWidth x tileHeight tiles and schedule whole
+// tiles instead of rows; a zero tile size restores row scheduling.
+// With tiledLayout the output buffer uses the tiled layout of
+// common/tileLayout.h and must be converted with detileImage (or
+// written with writePPMImageTiled).
+void setTiling(int tileWidth, int tileHeight, bool tiledLayout);
+
+// Use mandelEarlyOut (main cardioid / period-2 bulb test plus Brent
+// periodicity checking) for every pixel.  The image is unchanged.  This
+// kernel is scalar, so the SIMD level is ignored while it is enabled.
+void setEarlyOut(bool enabled);
+
+// Compute each tile with Mariani-Silver rectangle subdivision instead
+// of iterating every pixel.  Without an explicit tiling, 64x64 tiles
+// are used.  The SIMD level does not apply to this mode.
+void setMarianiSilver(bool enabled);
+
+// numThreads <= 0 uses one thread per hardware thread.  If busySeconds
+// is non-NULL, busySeconds[t] receives the time thread t spent
+// computing rows during this call.
+void mandelbrotThread(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations,
+    int output[],
+    ScheduleMode schedule = SCHED_INTERLEAVED,
+    double busySeconds[] = 0);
+
+void mandelbrotThreadSpawn(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations,
+    int output[],
+    ScheduleMode schedule = SCHED_INTERLEAVED,
+    double busySeconds[] = 0);
+
+// Deep-zoom frame prepared with prepareDeepFrame (common/deepZoom.h),
+// rendered by perturbation; the output is frame.width x frame.height.
+void mandelbrotThreadDeep(
+    int numThreads,
+    const DeepFrame& frame,
+    int maxIterations,
+    int output[],
+    ScheduleMode schedule = SCHED_INTERLEAVED,
+    double busySeconds[] = 0);
+
+// Receives rows [startRow, startRow + numRows) of a streamed image,
+// width ints per row.  Calls arrive one at a time, top to bottom.
+typedef std::function<void(const int* rows, int startRow, int numRows)> BandSink;
+
+// Render in bands of bandRows rows and pass each finished band to sink
+// in order, buffering at most 2 * numThreads bands.  Uses the SIMD and
+// early-out settings; rows are always scheduled dynamically.  Returns
+// the number of band buffers allocated.
+int mandelbrotThreadStream(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations,
+    int bandRows,
+    const BandSink& sink);
+
+// Compute the progressive pass with the given step (8, 4, 2 or 1) into
+// output, which holds the earlier passes.  Uses the SIMD and early-out
+// settings.  Returns false if cancel was set before the pass finished.
+bool mandelbrotThreadPass(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations,
+    int step,
+    int output[],
+    const CancelToken* cancel = 0);
+
+// Compute the rectangles of a frame at (colOffset, rowOffset) on the
+// pixel grid of viewport (x0, y0, x1, y1) at width x height, as used by
+// PanCache (common/panCache.h).  output is the frame, width ints per
+// row.  Uses the SIMD and early-out settings.
+void mandelbrotThreadRects(
+    int numThreads,
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int maxIterations,
+    int colOffset, int rowOffset,
+    const PanRect rects[], int numRects,
+    int output[]);
+
+#endif // _MANDELBROT_THREAD_H_
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include "threadPlacement.h"
+
+bool parsePinPolicy(const char* name, PinPolicy* policy)
+{
+    static const PinPolicy policies[] = { PIN_NONE, PIN_COMPACT, PIN_NUMA };
+    for (unsigned int i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        if (strcmp(name, pinPolicyName(policies[i])) == 0) {
+            *policy = policies[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* pinPolicyName(PinPolicy policy)
+{
+    switch (policy) {
+    case PIN_NONE:    return "none";
+    case PIN_COMPACT: return "compact";
+    case PIN_NUMA:    return "numa";
+    }
+    return "unknown";
+}
+
+int defaultThreadCount()
+{
+    unsigned int n = std::thread::hardware_concurrency();
+    return n > 0 ? (int)n : 1;
+}
+
+#if defined(__linux__)
+
+// CPUs the process was allowed to run on at startup.  Read once, before
+// anything is pinned: sched_getaffinity reports the calling thread's
+// mask, and the main thread pins itself along with the workers.
+static const cpu_set_t* processCpuSet()
+{
+    static cpu_set_t set;
+    static bool valid = false;
+    static bool initialized = false;
+    if (!initialized) {
+        CPU_ZERO(&set);
+        valid = sched_getaffinity(getpid(), sizeof(set), &set) == 0;
+        initialized = true;
+    }
+    return valid ? &set : NULL;
+}
+
+// CPUs the process may run on, in ascending order.
+static std::vector<int> allowedCpus()
+{
+    std::vector<int> cpus;
+    const cpu_set_t* set = processCpuSet();
+    if (!set)
+        return cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        if (CPU_ISSET(cpu, set))
+            cpus.push_back(cpu);
+    return cpus;
+}
+
+// Parse a sysfs cpulist such as "0-3,8-11" into set.
+static void parseCpuList(const char* list, cpu_set_t* set)
+{
+    const char* p = list;
+    while (*p) {
+        int first, last, consumed;
+        if (sscanf(p, "%d-%d%n", &first, &last, &consumed) != 2) {
+            if (sscanf(p, "%d%n", &first, &consumed) != 1)
+                break;
+            last = first;
+        }
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, set);
+        p += consumed;
+        if (*p == ',')
+            p++;
+        else
+            break;
+    }
+}
+
+// Allowed CPUs grouped by NUMA node.  Falls back to a single node when
+// sysfs topology is unavailable.
+static std::vector<std::vector<int> > cpusByNode()
+{
+    std::vector<int> allowed = allowedCpus();
+    std::vector<std::vector<int> > nodes;
+
+    for (int node = 0; ; node++) {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE* fp = fopen(path, "r");
+        if (!fp)
+            break;
+        char list[4096] = "";
+        if (!fgets(list, sizeof(list), fp))
+            list[0] = '\0';
+        fclose(fp);
+
+        cpu_set_t nodeSet;
+        CPU_ZERO(&nodeSet);
+        parseCpuList(list, &nodeSet);
+
+        std::vector<int> cpus;
+        for (size_t i = 0; i < allowed.size(); i++)
+            if (CPU_ISSET(allowed[i], &nodeSet))
+                cpus.push_back(allowed[i]);
+        if (!cpus.empty())
+            nodes.push_back(cpus);
+    }
+
+    if (nodes.empty() && !allowed.empty())
+        nodes.push_back(allowed);
+    return nodes;
+}
+
+std::vector<int> placementCpus(PinPolicy policy, int numThreads)
+{
+    std::vector<int> placement;
+
+    if (policy == PIN_COMPACT) {
+        std::vector<int> cpus = allowedCpus();
+        if (cpus.empty())
+            return placement;
+        for (int t = 0; t < numThreads; t++)
+            placement.push_back(cpus[t % cpus.size()]);
+    } else if (policy == PIN_NUMA) {
+        std::vector<std::vector<int> > nodes = cpusByNode();
+        if (nodes.empty())
+            return placement;
+        std::vector<size_t> nextInNode(nodes.size(), 0);
+        for (int t = 0; t < numThreads; t++) {
+            size_t node = t % nodes.size();
+            placement.push_back(nodes[node][nextInNode[node] % nodes[node].size()]);
+            nextInNode[node]++;
+        }
+    }
+
+    return placement;
+}
+
+bool pinCurrentThread(int cpu)
+{
+    processCpuSet();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+bool unpinCurrentThread()
+{
+    const cpu_set_t* set = processCpuSet();
+    return set && pthread_setaffinity_np(pthread_self(), sizeof(*set), set) == 0;
+}
+
+#else
+
+std::vector<int> placementCpus(PinPolicy, int)
+{
+    return std::vector<int>();
+}
+
+bool pinCurrentThread(int)
+{
+    return false;
+}
+
+bool unpinCurrentThread()
+{
+    return false;
+}
+
+#endif
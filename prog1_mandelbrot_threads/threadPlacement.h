@@ -0,0 +1,36 @@
+#ifndef _THREAD_PLACEMENT_H_
+#define _THREAD_PLACEMENT_H_
+
+#include <vector>
+
+//
+// Where worker threads are allowed to run.
+//
+// * PIN_NONE     leave placement to the OS scheduler
+// * PIN_COMPACT  thread t is pinned to the t-th CPU the process may use
+// * PIN_NUMA     threads are dealt round-robin over NUMA nodes, each one
+//                pinned to the next free CPU of its node
+enum PinPolicy {
+    PIN_NONE,
+    PIN_COMPACT,
+    PIN_NUMA
+};
+
+bool parsePinPolicy(const char* name, PinPolicy* policy);
+const char* pinPolicyName(PinPolicy policy);
+
+// Number of hardware threads, never less than 1.
+int defaultThreadCount();
+
+// CPU id for each of numThreads threads under policy, or an empty
+// vector for PIN_NONE or when affinity is not supported.
+std::vector<int> placementCpus(PinPolicy policy, int numThreads);
+
+// Restrict the calling thread to cpu.  Returns false on failure.
+bool pinCurrentThread(int cpu);
+
+// Let the calling thread run on every CPU the process started with.
+// Returns false on failure.
+bool unpinCurrentThread();
+
+#endif // _THREAD_PLACEMENT_H_
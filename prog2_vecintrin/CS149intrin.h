@@ -1,5 +1,19 @@
+// Backend: emulated (default) or native SIMD, selected at compile time
+// with -DCS149_BACKEND_SSE4, -DCS149_BACKEND_AVX2 or -DCS149_BACKEND_AVX512.
+// Native backends fix the vector width to that of their registers.
+#if defined(CS149_BACKEND_SSE4)
+#define CS149_NATIVE "sse4"
+#define VECTOR_WIDTH 4
+#elif defined(CS149_BACKEND_AVX2)
+#define CS149_NATIVE "avx2"
+#define VECTOR_WIDTH 8
+#elif defined(CS149_BACKEND_AVX512)
+#define CS149_NATIVE "avx512"
+#define VECTOR_WIDTH 16
+#else
 // Define vector unit width here
 #define VECTOR_WIDTH 4
+#endif
 
 #ifndef CS149INTRIN_H_
 #define CS149INTRIN_H_
@@ -14,13 +28,28 @@
 
 extern Logger CS149Logger;
 
-template <typename T>
+#ifdef CS149_NATIVE
+#include "CS149intrin_native.h"
+#else
+
+// Vectors and masks are templates on their width W, so that one program
+// can emulate several widths (see --width in main.cpp).  The names
+// below are the VECTOR_WIDTH-wide registers; code for any width uses
+// __cs149_vec<float, W>, __cs149_vec<int, W> and __cs149_vmask<W>.
+// The intrinsics deduce W from their operands; _cs149_init_ones and
+// the _cs149_vset_* forms that return a register take it as a template
+// argument, e.g. _cs149_init_ones<W>(), and default to VECTOR_WIDTH.
+
+template <typename T, int W = VECTOR_WIDTH>
 struct __cs149_vec {
-  T value[VECTOR_WIDTH];
+  T value[W];
 };
 
+template <int W = VECTOR_WIDTH>
+struct __cs149_vmask : __cs149_vec<bool, W> {};
+
 // Declare a mask with __cs149_mask
-struct __cs149_mask : __cs149_vec<bool> {};
+typedef __cs149_vmask<> __cs149_mask;
 
 // Declare a floating point vector register with __cs149_vec_float
 #define __cs149_vec_float __cs149_vec<float>
@@ -28,99 +57,323 @@ struct __cs149_mask : __cs149_vec<bool> {};
 // Declare an integer vector register with __cs149_vec_int
 #define __cs149_vec_int   __cs149_vec<int>
 
+//********************
+//* Logging Policies *
+//********************
+
+// The intrinsics are inline templates on a logging policy, a type with
+// a static log(instruction, mask, N).  CS149Log records every
+// instruction in CS149Logger; CS149NoLog does nothing and inlines away,
+// leaving only the lane loop of each intrinsic.  Calls without an
+// explicit policy, e.g. _cs149_vadd_float(r, a, b, mask), use
+// CS149_LOG_POLICY, which a build may set with -DCS149_LOG_POLICY=...;
+// a single call can choose one with _cs149_vadd_float<CS149NoLog>(...).
+
+struct CS149Log {
+  template <int W>
+  static void log(const char * instruction, const __cs149_vmask<W> &mask, int N) {
+    unsigned long long laneMask = 0;
+    for (int i=0; i<N; i++) {
+      if (mask.value[i]) laneMask |= (((unsigned long long)1)<<i);
+    }
+    CS149Logger.addLog(instruction, laneMask, N);
+  }
+};
+
+struct CS149NoLog {
+  template <int W>
+  static void log(const char * instruction, const __cs149_vmask<W> &mask, int N) {}
+};
+
+#ifndef CS149_LOG_POLICY
+#define CS149_LOG_POLICY CS149Log
+#endif
+
 //***********************
 //* Function Definition *
 //***********************
 
 // Return a mask initialized to 1 in the first N lanes and 0 in the others
-__cs149_mask _cs149_init_ones(int first = VECTOR_WIDTH);
+template <int W = VECTOR_WIDTH>
+inline __cs149_vmask<W> _cs149_init_ones(int first = W) {
+  __cs149_vmask<W> mask;
+  for (int i=0; i<W; i++) {
+    mask.value[i] = (i<first) ? true : false;
+  }
+  return mask;
+}
 
 // Return the inverse of maska
-__cs149_mask _cs149_mask_not(__cs149_mask &maska);
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline __cs149_vmask<W> _cs149_mask_not(const __cs149_vmask<W> &maska) {
+  __cs149_vmask<W> resultMask;
+  for (int i=0; i<W; i++) {
+    resultMask.value[i] = !maska.value[i];
+  }
+  Policy::log("masknot", _cs149_init_ones<W>(), W);
+  return resultMask;
+}
 
 // Return (maska | maskb)
-__cs149_mask _cs149_mask_or(__cs149_mask &maska, __cs149_mask &maskb);
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline __cs149_vmask<W> _cs149_mask_or(const __cs149_vmask<W> &maska, const __cs149_vmask<W> &maskb) {
+  __cs149_vmask<W> resultMask;
+  for (int i=0; i<W; i++) {
+    resultMask.value[i] = maska.value[i] | maskb.value[i];
+  }
+  Policy::log("maskor", _cs149_init_ones<W>(), W);
+  return resultMask;
+}
 
 // Return (maska & maskb)
-__cs149_mask _cs149_mask_and(__cs149_mask &maska, __cs149_mask &maskb);
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline __cs149_vmask<W> _cs149_mask_and(const __cs149_vmask<W> &maska, const __cs149_vmask<W> &maskb) {
+  __cs149_vmask<W> resultMask;
+  for (int i=0; i<W; i++) {
+    resultMask.value[i] = maska.value[i] && maskb.value[i];
+  }
+  Policy::log("maskand", _cs149_init_ones<W>(), W);
+  return resultMask;
+}
 
 // Count the number of 1s in maska
-int _cs149_cntbits(__cs149_mask &maska);
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline int _cs149_cntbits(const __cs149_vmask<W> &maska) {
+  int count = 0;
+  for (int i=0; i<W; i++) {
+    if (maska.value[i]) count++;
+  }
+  Policy::log("cntbits", _cs149_init_ones<W>(), W);
+  return count;
+}
 
 // Set register to value if vector lane is active
 //  otherwise keep the old value
-void _cs149_vset_float(__cs149_vec_float &vecResult, float value, __cs149_mask &mask);
-void _cs149_vset_int(__cs149_vec_int &vecResult, int value, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vset(__cs149_vec<T, W> &vecResult, T value, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    vecResult.value[i] = mask.value[i] ? value : vecResult.value[i];
+  }
+  Policy::log("vset", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vset_float(__cs149_vec<float, W> &vecResult, float value, const __cs149_vmask<W> &mask) { _cs149_vset<Policy>(vecResult, value, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vset_int(__cs149_vec<int, W> &vecResult, int value, const __cs149_vmask<W> &mask) { _cs149_vset<Policy>(vecResult, value, mask); }
+
 // For user's convenience, returns a vector register with all lanes initialized to value
-__cs149_vec_float _cs149_vset_float(float value);
-__cs149_vec_int _cs149_vset_int(int value);
+template <int W = VECTOR_WIDTH, typename Policy = CS149_LOG_POLICY>
+inline __cs149_vec<float, W> _cs149_vset_float(float value) {
+  __cs149_vec<float, W> vecResult;
+  _cs149_vset<Policy>(vecResult, value, _cs149_init_ones<W>());
+  return vecResult;
+}
+template <int W = VECTOR_WIDTH, typename Policy = CS149_LOG_POLICY>
+inline __cs149_vec<int, W> _cs149_vset_int(int value) {
+  __cs149_vec<int, W> vecResult;
+  _cs149_vset<Policy>(vecResult, value, _cs149_init_ones<W>());
+  return vecResult;
+}
 
 // Copy values from vector register src to vector register dest if vector lane active
 // otherwise keep the old value
-void _cs149_vmove_float(__cs149_vec_float &dest, __cs149_vec_float &src, __cs149_mask &mask);
-void _cs149_vmove_int(__cs149_vec_int &dest, __cs149_vec_int &src, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vmove(__cs149_vec<T, W> &dest, const __cs149_vec<T, W> &src, const __cs149_vmask<W> &mask) {
+  for (int i = 0; i < W; i++) {
+    dest.value[i] = mask.value[i] ? src.value[i] : dest.value[i];
+  }
+  Policy::log("vmove", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vmove_float(__cs149_vec<float, W> &dest, const __cs149_vec<float, W> &src, const __cs149_vmask<W> &mask) { _cs149_vmove<Policy>(dest, src, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vmove_int(__cs149_vec<int, W> &dest, const __cs149_vec<int, W> &src, const __cs149_vmask<W> &mask) { _cs149_vmove<Policy>(dest, src, mask); }
 
 // Load values from array src to vector register dest if vector lane active
 //  otherwise keep the old value
-void _cs149_vload_float(__cs149_vec_float &dest, float* src, __cs149_mask &mask);
-void _cs149_vload_int(__cs149_vec_int &dest, int* src, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vload(__cs149_vec<T, W> &dest, const T* src, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    dest.value[i] = mask.value[i] ? src[i] : dest.value[i];
+  }
+  Policy::log("vload", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vload_float(__cs149_vec<float, W> &dest, const float* src, const __cs149_vmask<W> &mask) { _cs149_vload<Policy>(dest, src, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vload_int(__cs149_vec<int, W> &dest, const int* src, const __cs149_vmask<W> &mask) { _cs149_vload<Policy>(dest, src, mask); }
 
 // Store values from vector register src to array dest if vector lane active
 //  otherwise keep the old value
-void _cs149_vstore_float(float* dest, __cs149_vec_float &src, __cs149_mask &mask);
-void _cs149_vstore_int(int* dest, __cs149_vec_int &src, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vstore(T* dest, const __cs149_vec<T, W> &src, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    dest[i] = mask.value[i] ? src.value[i] : dest[i];
+  }
+  Policy::log("vstore", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vstore_float(float* dest, const __cs149_vec<float, W> &src, const __cs149_vmask<W> &mask) { _cs149_vstore<Policy>(dest, src, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vstore_int(int* dest, const __cs149_vec<int, W> &src, const __cs149_vmask<W> &mask) { _cs149_vstore<Policy>(dest, src, mask); }
 
 // Return calculation of (veca + vecb) if vector lane active
 //  otherwise keep the old value
-void _cs149_vadd_float(__cs149_vec_float &vecResult, __cs149_vec_float &veca, __cs149_vec_float &vecb, __cs149_mask &mask);
-void _cs149_vadd_int(__cs149_vec_int &vecResult, __cs149_vec_int &veca, __cs149_vec_int &vecb, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vadd(__cs149_vec<T, W> &vecResult, const __cs149_vec<T, W> &veca, const __cs149_vec<T, W> &vecb, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    vecResult.value[i] = mask.value[i] ? (veca.value[i] + vecb.value[i]) : vecResult.value[i];
+  }
+  Policy::log("vadd", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vadd_float(__cs149_vec<float, W> &vecResult, const __cs149_vec<float, W> &veca, const __cs149_vec<float, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vadd<Policy>(vecResult, veca, vecb, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vadd_int(__cs149_vec<int, W> &vecResult, const __cs149_vec<int, W> &veca, const __cs149_vec<int, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vadd<Policy>(vecResult, veca, vecb, mask); }
 
 // Return calculation of (veca - vecb) if vector lane active
 //  otherwise keep the old value
-void _cs149_vsub_float(__cs149_vec_float &vecResult, __cs149_vec_float &veca, __cs149_vec_float &vecb, __cs149_mask &mask);
-void _cs149_vsub_int(__cs149_vec_int &vecResult, __cs149_vec_int &veca, __cs149_vec_int &vecb, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vsub(__cs149_vec<T, W> &vecResult, const __cs149_vec<T, W> &veca, const __cs149_vec<T, W> &vecb, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    vecResult.value[i] = mask.value[i] ? (veca.value[i] - vecb.value[i]) : vecResult.value[i];
+  }
+  Policy::log("vsub", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vsub_float(__cs149_vec<float, W> &vecResult, const __cs149_vec<float, W> &veca, const __cs149_vec<float, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vsub<Policy>(vecResult, veca, vecb, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vsub_int(__cs149_vec<int, W> &vecResult, const __cs149_vec<int, W> &veca, const __cs149_vec<int, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vsub<Policy>(vecResult, veca, vecb, mask); }
 
 // Return calculation of (veca * vecb) if vector lane active
 //  otherwise keep the old value
-void _cs149_vmult_float(__cs149_vec_float &vecResult, __cs149_vec_float &veca, __cs149_vec_float &vecb, __cs149_mask &mask);
-void _cs149_vmult_int(__cs149_vec_int &vecResult, __cs149_vec_int &veca, __cs149_vec_int &vecb, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vmult(__cs149_vec<T, W> &vecResult, const __cs149_vec<T, W> &veca, const __cs149_vec<T, W> &vecb, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    vecResult.value[i] = mask.value[i] ? (veca.value[i] * vecb.value[i]) : vecResult.value[i];
+  }
+  Policy::log("vmult", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vmult_float(__cs149_vec<float, W> &vecResult, const __cs149_vec<float, W> &veca, const __cs149_vec<float, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vmult<Policy>(vecResult, veca, vecb, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vmult_int(__cs149_vec<int, W> &vecResult, const __cs149_vec<int, W> &veca, const __cs149_vec<int, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vmult<Policy>(vecResult, veca, vecb, mask); }
 
 // Return calculation of (veca / vecb) if vector lane active
 //  otherwise keep the old value
-void _cs149_vdiv_float(__cs149_vec_float &vecResult, __cs149_vec_float &veca, __cs149_vec_float &vecb, __cs149_mask &mask);
-void _cs149_vdiv_int(__cs149_vec_int &vecResult, __cs149_vec_int &veca, __cs149_vec_int &vecb, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vdiv(__cs149_vec<T, W> &vecResult, const __cs149_vec<T, W> &veca, const __cs149_vec<T, W> &vecb, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    vecResult.value[i] = mask.value[i] ? (veca.value[i] / vecb.value[i]) : vecResult.value[i];
+  }
+  Policy::log("vdiv", mask, W);
+}
 
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vdiv_float(__cs149_vec<float, W> &vecResult, const __cs149_vec<float, W> &veca, const __cs149_vec<float, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vdiv<Policy>(vecResult, veca, vecb, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vdiv_int(__cs149_vec<int, W> &vecResult, const __cs149_vec<int, W> &veca, const __cs149_vec<int, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vdiv<Policy>(vecResult, veca, vecb, mask); }
 
 // Return calculation of absolute value abs(veca) if vector lane active
 //  otherwise keep the old value
-void _cs149_vabs_float(__cs149_vec_float &vecResult, __cs149_vec_float &veca, __cs149_mask &mask);
-void _cs149_vabs_int(__cs149_vec_int &vecResult, __cs149_vec_int &veca, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vabs(__cs149_vec<T, W> &vecResult, const __cs149_vec<T, W> &veca, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    vecResult.value[i] = mask.value[i] ? (abs(veca.value[i])) : vecResult.value[i];
+  }
+  Policy::log("vabs", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vabs_float(__cs149_vec<float, W> &vecResult, const __cs149_vec<float, W> &veca, const __cs149_vmask<W> &mask) { _cs149_vabs<Policy>(vecResult, veca, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vabs_int(__cs149_vec<int, W> &vecResult, const __cs149_vec<int, W> &veca, const __cs149_vmask<W> &mask) { _cs149_vabs<Policy>(vecResult, veca, mask); }
 
 // Return a mask of (veca > vecb) if vector lane active
 //  otherwise keep the old value
-void _cs149_vgt_float(__cs149_mask &vecResult, __cs149_vec_float &veca, __cs149_vec_float &vecb, __cs149_mask &mask);
-void _cs149_vgt_int(__cs149_mask &vecResult, __cs149_vec_int &veca, __cs149_vec_int &vecb, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vgt(__cs149_vmask<W> &maskResult, const __cs149_vec<T, W> &veca, const __cs149_vec<T, W> &vecb, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    maskResult.value[i] = mask.value[i] ? (veca.value[i] > vecb.value[i]) : maskResult.value[i];
+  }
+  Policy::log("vgt", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vgt_float(__cs149_vmask<W> &maskResult, const __cs149_vec<float, W> &veca, const __cs149_vec<float, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vgt<Policy>(maskResult, veca, vecb, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vgt_int(__cs149_vmask<W> &maskResult, const __cs149_vec<int, W> &veca, const __cs149_vec<int, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vgt<Policy>(maskResult, veca, vecb, mask); }
 
 // Return a mask of (veca < vecb) if vector lane active
 //  otherwise keep the old value
-void _cs149_vlt_float(__cs149_mask &vecResult, __cs149_vec_float &veca, __cs149_vec_float &vecb, __cs149_mask &mask);
-void _cs149_vlt_int(__cs149_mask &vecResult, __cs149_vec_int &veca, __cs149_vec_int &vecb, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_vlt(__cs149_vmask<W> &maskResult, const __cs149_vec<T, W> &veca, const __cs149_vec<T, W> &vecb, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    maskResult.value[i] = mask.value[i] ? (veca.value[i] < vecb.value[i]) : maskResult.value[i];
+  }
+  Policy::log("vlt", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vlt_float(__cs149_vmask<W> &maskResult, const __cs149_vec<float, W> &veca, const __cs149_vec<float, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vlt<Policy>(maskResult, veca, vecb, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_vlt_int(__cs149_vmask<W> &maskResult, const __cs149_vec<int, W> &veca, const __cs149_vec<int, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_vlt<Policy>(maskResult, veca, vecb, mask); }
 
 // Return a mask of (veca == vecb) if vector lane active
 //  otherwise keep the old value
-void _cs149_veq_float(__cs149_mask &vecResult, __cs149_vec_float &veca, __cs149_vec_float &vecb, __cs149_mask &mask);
-void _cs149_veq_int(__cs149_mask &vecResult, __cs149_vec_int &veca, __cs149_vec_int &vecb, __cs149_mask &mask);
+template <typename Policy, typename T, int W>
+inline void _cs149_veq(__cs149_vmask<W> &maskResult, const __cs149_vec<T, W> &veca, const __cs149_vec<T, W> &vecb, const __cs149_vmask<W> &mask) {
+  for (int i=0; i<W; i++) {
+    maskResult.value[i] = mask.value[i] ? (veca.value[i] == vecb.value[i]) : maskResult.value[i];
+  }
+  Policy::log("veq", mask, W);
+}
+
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_veq_float(__cs149_vmask<W> &maskResult, const __cs149_vec<float, W> &veca, const __cs149_vec<float, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_veq<Policy>(maskResult, veca, vecb, mask); }
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_veq_int(__cs149_vmask<W> &maskResult, const __cs149_vec<int, W> &veca, const __cs149_vec<int, W> &vecb, const __cs149_vmask<W> &mask) { _cs149_veq<Policy>(maskResult, veca, vecb, mask); }
 
 // Adds up adjacent pairs of elements, so
 //  [0 1 2 3] -> [0+1 0+1 2+3 2+3]
-void _cs149_hadd_float(__cs149_vec_float &vecResult, __cs149_vec_float &vec);
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_hadd_float(__cs149_vec<float, W> &vecResult, const __cs149_vec<float, W> &vec) {
+  // vecResult may be vec: read both elements of a pair before writing
+  for (int i=0; i<W/2; i++) {
+    float result = vec.value[2*i] + vec.value[2*i+1];
+    vecResult.value[2 * i] = result;
+    vecResult.value[2 * i + 1] = result;
+  }
+  Policy::log("hadd", _cs149_init_ones<W>(), W);
+}
 
 // Performs an even-odd interleaving where all even-indexed elements move to front half
 //  of the array and odd-indexed to the back half, so
 //  [0 1 2 3 4 5 6 7] -> [0 2 4 6 1 3 5 7]
-void _cs149_interleave_float(__cs149_vec_float &vecResult, __cs149_vec_float &vec);
+template <typename Policy = CS149_LOG_POLICY, int W>
+inline void _cs149_interleave_float(__cs149_vec<float, W> &vecResult, const __cs149_vec<float, W> &vec) {
+  // vecResult may be vec, so permute from a copy
+  __cs149_vec<float, W> src = vec;
+  for (int i=0; i<W; i++) {
+    int index = i < W/2 ? (2 * i) : (2 * (i - W/2) + 1);
+    vecResult.value[i] = src.value[index];
+  }
+  Policy::log("interleave", _cs149_init_ones<W>(), W);
+}
 
 // Add a customized log to help debugging
-void addUserLog(const char * logStr);
+template <typename Policy = CS149_LOG_POLICY>
+inline void addUserLog(const char * logStr) {
+  Policy::log(logStr, _cs149_init_ones(), 0);
+}
+
+#endif // CS149_NATIVE
 
 #endif
@@ -0,0 +1,524 @@
+#ifndef CS149INTRIN_NATIVE_H_
+#define CS149INTRIN_NATIVE_H_
+
+//*******************
+//* Native backends *
+//*******************
+//
+// Included by CS149intrin.h when a build defines CS149_BACKEND_SSE4,
+// CS149_BACKEND_AVX2 or CS149_BACKEND_AVX512 (see `make native`).  The
+// vector types then hold real SIMD registers and the intrinsics are
+// inline wrappers around the hardware instructions, with the semantics
+// documented in CS149intrin.h: lanes whose mask bit is off keep their
+// old value and inactive lanes of loads and stores do not touch
+// memory.  Nothing is logged, so the Logger statistics are empty.
+//
+// Float and int vectors overlay their register with a value[] array,
+// so code that reads single lanes (e.g. sum.value[0]) works unchanged.
+// They and the masks are the VECTOR_WIDTH specializations of the
+// emulator's width templates; other widths are left undefined, so code
+// written for any W compiles only at the native width.
+// Masks are all-ones lanes of an integer register for SSE4 and AVX2,
+// and a __mmask16 for AVX-512.  Integer division has no SIMD
+// instruction and is done lane by lane.
+
+#include <immintrin.h>
+
+template <typename T, int W = VECTOR_WIDTH>
+struct __cs149_vec;
+
+template <int W = VECTOR_WIDTH>
+struct __cs149_vmask;
+
+typedef __cs149_vmask<> __cs149_mask;
+#define __cs149_vec_float __cs149_vec<float>
+#define __cs149_vec_int   __cs149_vec<int>
+
+#if defined(CS149_BACKEND_SSE4)
+
+template <>
+struct __cs149_vec<float, VECTOR_WIDTH> { union { __m128 v; float value[VECTOR_WIDTH]; }; };
+template <>
+struct __cs149_vec<int, VECTOR_WIDTH> { union { __m128i v; int value[VECTOR_WIDTH]; }; };
+template <>
+struct __cs149_vmask<VECTOR_WIDTH> { __m128i v; };
+
+// Bit i set if lane i of mask is active
+inline int __cs149_lanes(const __cs149_mask &mask) {
+  return _mm_movemask_ps(_mm_castsi128_ps(mask.v));
+}
+
+inline __m128 __cs149_blend(__m128 old, __m128 value, const __cs149_mask &mask) {
+  return _mm_blendv_ps(old, value, _mm_castsi128_ps(mask.v));
+}
+
+inline __m128i __cs149_blend(__m128i old, __m128i value, const __cs149_mask &mask) {
+  return _mm_blendv_epi8(old, value, mask.v);
+}
+
+template <int W = VECTOR_WIDTH>
+inline __cs149_vmask<W> _cs149_init_ones(int first = VECTOR_WIDTH) {
+  __cs149_mask mask;
+  mask.v = _mm_cmpgt_epi32(_mm_set1_epi32(first), _mm_setr_epi32(0, 1, 2, 3));
+  return mask;
+}
+
+inline __cs149_mask _cs149_mask_not(const __cs149_mask &maska) {
+  __cs149_mask resultMask;
+  resultMask.v = _mm_xor_si128(maska.v, _mm_set1_epi32(-1));
+  return resultMask;
+}
+
+inline __cs149_mask _cs149_mask_or(const __cs149_mask &maska, const __cs149_mask &maskb) {
+  __cs149_mask resultMask;
+  resultMask.v = _mm_or_si128(maska.v, maskb.v);
+  return resultMask;
+}
+
+inline __cs149_mask _cs149_mask_and(const __cs149_mask &maska, const __cs149_mask &maskb) {
+  __cs149_mask resultMask;
+  resultMask.v = _mm_and_si128(maska.v, maskb.v);
+  return resultMask;
+}
+
+inline void _cs149_vset_float(__cs149_vec_float &vecResult, float value, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_set1_ps(value), mask);
+}
+inline void _cs149_vset_int(__cs149_vec_int &vecResult, int value, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_set1_epi32(value), mask);
+}
+template <int W = VECTOR_WIDTH>
+inline __cs149_vec<float, W> _cs149_vset_float(float value) {
+  __cs149_vec_float vecResult;
+  vecResult.v = _mm_set1_ps(value);
+  return vecResult;
+}
+template <int W = VECTOR_WIDTH>
+inline __cs149_vec<int, W> _cs149_vset_int(int value) {
+  __cs149_vec_int vecResult;
+  vecResult.v = _mm_set1_epi32(value);
+  return vecResult;
+}
+
+// SSE has no masked load or store; partial masks go lane by lane
+inline void _cs149_vload_float(__cs149_vec_float &dest, const float* src, const __cs149_mask &mask) {
+  int lanes = __cs149_lanes(mask);
+  if (lanes == 0xf) {
+    dest.v = _mm_loadu_ps(src);
+    return;
+  }
+  for (int i=0; i<VECTOR_WIDTH; i++) {
+    if (lanes & (1 << i)) dest.value[i] = src[i];
+  }
+}
+inline void _cs149_vload_int(__cs149_vec_int &dest, const int* src, const __cs149_mask &mask) {
+  int lanes = __cs149_lanes(mask);
+  if (lanes == 0xf) {
+    dest.v = _mm_loadu_si128((const __m128i*)src);
+    return;
+  }
+  for (int i=0; i<VECTOR_WIDTH; i++) {
+    if (lanes & (1 << i)) dest.value[i] = src[i];
+  }
+}
+
+inline void _cs149_vstore_float(float* dest, const __cs149_vec_float &src, const __cs149_mask &mask) {
+  int lanes = __cs149_lanes(mask);
+  if (lanes == 0xf) {
+    _mm_storeu_ps(dest, src.v);
+    return;
+  }
+  for (int i=0; i<VECTOR_WIDTH; i++) {
+    if (lanes & (1 << i)) dest[i] = src.value[i];
+  }
+}
+inline void _cs149_vstore_int(int* dest, const __cs149_vec_int &src, const __cs149_mask &mask) {
+  int lanes = __cs149_lanes(mask);
+  if (lanes == 0xf) {
+    _mm_storeu_si128((__m128i*)dest, src.v);
+    return;
+  }
+  for (int i=0; i<VECTOR_WIDTH; i++) {
+    if (lanes & (1 << i)) dest[i] = src.value[i];
+  }
+}
+
+inline void _cs149_vadd_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_add_ps(veca.v, vecb.v), mask);
+}
+inline void _cs149_vadd_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_add_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_vsub_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_sub_ps(veca.v, vecb.v), mask);
+}
+inline void _cs149_vsub_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_sub_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_vmult_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_mul_ps(veca.v, vecb.v), mask);
+}
+inline void _cs149_vmult_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_mullo_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_vdiv_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_div_ps(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_vabs_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_andnot_ps(_mm_set1_ps(-0.f), veca.v), mask);
+}
+inline void _cs149_vabs_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm_abs_epi32(veca.v), mask);
+}
+
+inline void _cs149_vgt_float(__cs149_mask &maskResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm_castps_si128(_mm_cmpgt_ps(veca.v, vecb.v)), mask);
+}
+inline void _cs149_vgt_int(__cs149_mask &maskResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm_cmpgt_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_vlt_float(__cs149_mask &maskResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm_castps_si128(_mm_cmplt_ps(veca.v, vecb.v)), mask);
+}
+inline void _cs149_vlt_int(__cs149_mask &maskResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm_cmplt_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_veq_float(__cs149_mask &maskResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm_castps_si128(_mm_cmpeq_ps(veca.v, vecb.v)), mask);
+}
+inline void _cs149_veq_int(__cs149_mask &maskResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm_cmpeq_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_hadd_float(__cs149_vec_float &vecResult, const __cs149_vec_float &vec) {
+  vecResult.v = _mm_add_ps(vec.v, _mm_shuffle_ps(vec.v, vec.v, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+inline void _cs149_interleave_float(__cs149_vec_float &vecResult, const __cs149_vec_float &vec) {
+  vecResult.v = _mm_shuffle_ps(vec.v, vec.v, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+#elif defined(CS149_BACKEND_AVX2)
+
+template <>
+struct __cs149_vec<float, VECTOR_WIDTH> { union { __m256 v; float value[VECTOR_WIDTH]; }; };
+template <>
+struct __cs149_vec<int, VECTOR_WIDTH> { union { __m256i v; int value[VECTOR_WIDTH]; }; };
+template <>
+struct __cs149_vmask<VECTOR_WIDTH> { __m256i v; };
+
+// Bit i set if lane i of mask is active
+inline int __cs149_lanes(const __cs149_mask &mask) {
+  return _mm256_movemask_ps(_mm256_castsi256_ps(mask.v));
+}
+
+inline __m256 __cs149_blend(__m256 old, __m256 value, const __cs149_mask &mask) {
+  return _mm256_blendv_ps(old, value, _mm256_castsi256_ps(mask.v));
+}
+
+inline __m256i __cs149_blend(__m256i old, __m256i value, const __cs149_mask &mask) {
+  return _mm256_blendv_epi8(old, value, mask.v);
+}
+
+template <int W = VECTOR_WIDTH>
+inline __cs149_vmask<W> _cs149_init_ones(int first = VECTOR_WIDTH) {
+  __cs149_mask mask;
+  mask.v = _mm256_cmpgt_epi32(_mm256_set1_epi32(first), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  return mask;
+}
+
+inline __cs149_mask _cs149_mask_not(const __cs149_mask &maska) {
+  __cs149_mask resultMask;
+  resultMask.v = _mm256_xor_si256(maska.v, _mm256_set1_epi32(-1));
+  return resultMask;
+}
+
+inline __cs149_mask _cs149_mask_or(const __cs149_mask &maska, const __cs149_mask &maskb) {
+  __cs149_mask resultMask;
+  resultMask.v = _mm256_or_si256(maska.v, maskb.v);
+  return resultMask;
+}
+
+inline __cs149_mask _cs149_mask_and(const __cs149_mask &maska, const __cs149_mask &maskb) {
+  __cs149_mask resultMask;
+  resultMask.v = _mm256_and_si256(maska.v, maskb.v);
+  return resultMask;
+}
+
+inline void _cs149_vset_float(__cs149_vec_float &vecResult, float value, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_set1_ps(value), mask);
+}
+inline void _cs149_vset_int(__cs149_vec_int &vecResult, int value, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_set1_epi32(value), mask);
+}
+template <int W = VECTOR_WIDTH>
+inline __cs149_vec<float, W> _cs149_vset_float(float value) {
+  __cs149_vec_float vecResult;
+  vecResult.v = _mm256_set1_ps(value);
+  return vecResult;
+}
+template <int W = VECTOR_WIDTH>
+inline __cs149_vec<int, W> _cs149_vset_int(int value) {
+  __cs149_vec_int vecResult;
+  vecResult.v = _mm256_set1_epi32(value);
+  return vecResult;
+}
+
+inline void _cs149_vload_float(__cs149_vec_float &dest, const float* src, const __cs149_mask &mask) {
+  if (__cs149_lanes(mask) == 0xff)
+    dest.v = _mm256_loadu_ps(src);
+  else
+    dest.v = __cs149_blend(dest.v, _mm256_maskload_ps(src, mask.v), mask);
+}
+inline void _cs149_vload_int(__cs149_vec_int &dest, const int* src, const __cs149_mask &mask) {
+  if (__cs149_lanes(mask) == 0xff)
+    dest.v = _mm256_loadu_si256((const __m256i*)src);
+  else
+    dest.v = __cs149_blend(dest.v, _mm256_maskload_epi32(src, mask.v), mask);
+}
+
+inline void _cs149_vstore_float(float* dest, const __cs149_vec_float &src, const __cs149_mask &mask) {
+  _mm256_maskstore_ps(dest, mask.v, src.v);
+}
+inline void _cs149_vstore_int(int* dest, const __cs149_vec_int &src, const __cs149_mask &mask) {
+  _mm256_maskstore_epi32(dest, mask.v, src.v);
+}
+
+inline void _cs149_vadd_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_add_ps(veca.v, vecb.v), mask);
+}
+inline void _cs149_vadd_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_add_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_vsub_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_sub_ps(veca.v, vecb.v), mask);
+}
+inline void _cs149_vsub_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_sub_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_vmult_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_mul_ps(veca.v, vecb.v), mask);
+}
+inline void _cs149_vmult_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_mullo_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_vdiv_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_div_ps(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_vabs_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_andnot_ps(_mm256_set1_ps(-0.f), veca.v), mask);
+}
+inline void _cs149_vabs_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm256_abs_epi32(veca.v), mask);
+}
+
+inline void _cs149_vgt_float(__cs149_mask &maskResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm256_castps_si256(_mm256_cmp_ps(veca.v, vecb.v, _CMP_GT_OQ)), mask);
+}
+inline void _cs149_vgt_int(__cs149_mask &maskResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm256_cmpgt_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_vlt_float(__cs149_mask &maskResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm256_castps_si256(_mm256_cmp_ps(veca.v, vecb.v, _CMP_LT_OQ)), mask);
+}
+inline void _cs149_vlt_int(__cs149_mask &maskResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm256_cmpgt_epi32(vecb.v, veca.v), mask);
+}
+
+inline void _cs149_veq_float(__cs149_mask &maskResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm256_castps_si256(_mm256_cmp_ps(veca.v, vecb.v, _CMP_EQ_OQ)), mask);
+}
+inline void _cs149_veq_int(__cs149_mask &maskResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  maskResult.v = __cs149_blend(maskResult.v, _mm256_cmpeq_epi32(veca.v, vecb.v), mask);
+}
+
+inline void _cs149_hadd_float(__cs149_vec_float &vecResult, const __cs149_vec_float &vec) {
+  vecResult.v = _mm256_add_ps(vec.v, _mm256_permute_ps(vec.v, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+inline void _cs149_interleave_float(__cs149_vec_float &vecResult, const __cs149_vec_float &vec) {
+  vecResult.v = _mm256_permutevar8x32_ps(vec.v, _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7));
+}
+
+#elif defined(CS149_BACKEND_AVX512)
+
+template <>
+struct __cs149_vec<float, VECTOR_WIDTH> { union { __m512 v; float value[VECTOR_WIDTH]; }; };
+template <>
+struct __cs149_vec<int, VECTOR_WIDTH> { union { __m512i v; int value[VECTOR_WIDTH]; }; };
+template <>
+struct __cs149_vmask<VECTOR_WIDTH> { __mmask16 v; };
+
+// Bit i set if lane i of mask is active
+inline int __cs149_lanes(const __cs149_mask &mask) {
+  return mask.v;
+}
+
+inline __m512 __cs149_blend(__m512 old, __m512 value, const __cs149_mask &mask) {
+  return _mm512_mask_mov_ps(old, mask.v, value);
+}
+
+inline __m512i __cs149_blend(__m512i old, __m512i value, const __cs149_mask &mask) {
+  return _mm512_mask_mov_epi32(old, mask.v, value);
+}
+
+template <int W = VECTOR_WIDTH>
+inline __cs149_vmask<W> _cs149_init_ones(int first = VECTOR_WIDTH) {
+  __cs149_mask mask;
+  mask.v = first >= VECTOR_WIDTH ? 0xffff : first <= 0 ? 0 : (__mmask16)((1u << first) - 1);
+  return mask;
+}
+
+inline __cs149_mask _cs149_mask_not(const __cs149_mask &maska) {
+  __cs149_mask resultMask;
+  resultMask.v = (__mmask16)~maska.v;
+  return resultMask;
+}
+
+inline __cs149_mask _cs149_mask_or(const __cs149_mask &maska, const __cs149_mask &maskb) {
+  __cs149_mask resultMask;
+  resultMask.v = maska.v | maskb.v;
+  return resultMask;
+}
+
+inline __cs149_mask _cs149_mask_and(const __cs149_mask &maska, const __cs149_mask &maskb) {
+  __cs149_mask resultMask;
+  resultMask.v = maska.v & maskb.v;
+  return resultMask;
+}
+
+inline void _cs149_vset_float(__cs149_vec_float &vecResult, float value, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm512_set1_ps(value), mask);
+}
+inline void _cs149_vset_int(__cs149_vec_int &vecResult, int value, const __cs149_mask &mask) {
+  vecResult.v = __cs149_blend(vecResult.v, _mm512_set1_epi32(value), mask);
+}
+template <int W = VECTOR_WIDTH>
+inline __cs149_vec<float, W> _cs149_vset_float(float value) {
+  __cs149_vec_float vecResult;
+  vecResult.v = _mm512_set1_ps(value);
+  return vecResult;
+}
+template <int W = VECTOR_WIDTH>
+inline __cs149_vec<int, W> _cs149_vset_int(int value) {
+  __cs149_vec_int vecResult;
+  vecResult.v = _mm512_set1_epi32(value);
+  return vecResult;
+}
+
+inline void _cs149_vload_float(__cs149_vec_float &dest, const float* src, const __cs149_mask &mask) {
+  dest.v = _mm512_mask_loadu_ps(dest.v, mask.v, src);
+}
+inline void _cs149_vload_int(__cs149_vec_int &dest, const int* src, const __cs149_mask &mask) {
+  dest.v = _mm512_mask_loadu_epi32(dest.v, mask.v, src);
+}
+
+inline void _cs149_vstore_float(float* dest, const __cs149_vec_float &src, const __cs149_mask &mask) {
+  _mm512_mask_storeu_ps(dest, mask.v, src.v);
+}
+inline void _cs149_vstore_int(int* dest, const __cs149_vec_int &src, const __cs149_mask &mask) {
+  _mm512_mask_storeu_epi32(dest, mask.v, src.v);
+}
+
+inline void _cs149_vadd_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = _mm512_mask_add_ps(vecResult.v, mask.v, veca.v, vecb.v);
+}
+inline void _cs149_vadd_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  vecResult.v = _mm512_mask_add_epi32(vecResult.v, mask.v, veca.v, vecb.v);
+}
+
+inline void _cs149_vsub_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = _mm512_mask_sub_ps(vecResult.v, mask.v, veca.v, vecb.v);
+}
+inline void _cs149_vsub_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  vecResult.v = _mm512_mask_sub_epi32(vecResult.v, mask.v, veca.v, vecb.v);
+}
+
+inline void _cs149_vmult_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = _mm512_mask_mul_ps(vecResult.v, mask.v, veca.v, vecb.v);
+}
+inline void _cs149_vmult_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  vecResult.v = _mm512_mask_mullo_epi32(vecResult.v, mask.v, veca.v, vecb.v);
+}
+
+inline void _cs149_vdiv_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  vecResult.v = _mm512_mask_div_ps(vecResult.v, mask.v, veca.v, vecb.v);
+}
+
+inline void _cs149_vabs_float(__cs149_vec_float &vecResult, const __cs149_vec_float &veca, const __cs149_mask &mask) {
+  vecResult.v = _mm512_mask_abs_ps(vecResult.v, mask.v, veca.v);
+}
+inline void _cs149_vabs_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_mask &mask) {
+  vecResult.v = _mm512_mask_abs_epi32(vecResult.v, mask.v, veca.v);
+}
+
+// Compares only set the active lanes of maskResult
+inline void _cs149_vgt_float(__cs149_mask &maskResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  maskResult.v = (maskResult.v & ~mask.v) | _mm512_mask_cmp_ps_mask(mask.v, veca.v, vecb.v, _CMP_GT_OQ);
+}
+inline void _cs149_vgt_int(__cs149_mask &maskResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  maskResult.v = (maskResult.v & ~mask.v) | _mm512_mask_cmpgt_epi32_mask(mask.v, veca.v, vecb.v);
+}
+
+inline void _cs149_vlt_float(__cs149_mask &maskResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  maskResult.v = (maskResult.v & ~mask.v) | _mm512_mask_cmp_ps_mask(mask.v, veca.v, vecb.v, _CMP_LT_OQ);
+}
+inline void _cs149_vlt_int(__cs149_mask &maskResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  maskResult.v = (maskResult.v & ~mask.v) | _mm512_mask_cmplt_epi32_mask(mask.v, veca.v, vecb.v);
+}
+
+inline void _cs149_veq_float(__cs149_mask &maskResult, const __cs149_vec_float &veca, const __cs149_vec_float &vecb, const __cs149_mask &mask) {
+  maskResult.v = (maskResult.v & ~mask.v) | _mm512_mask_cmp_ps_mask(mask.v, veca.v, vecb.v, _CMP_EQ_OQ);
+}
+inline void _cs149_veq_int(__cs149_mask &maskResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  maskResult.v = (maskResult.v & ~mask.v) | _mm512_mask_cmpeq_epi32_mask(mask.v, veca.v, vecb.v);
+}
+
+inline void _cs149_hadd_float(__cs149_vec_float &vecResult, const __cs149_vec_float &vec) {
+  vecResult.v = _mm512_add_ps(vec.v, _mm512_permute_ps(vec.v, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+inline void _cs149_interleave_float(__cs149_vec_float &vecResult, const __cs149_vec_float &vec) {
+  const __m512i index = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+  vecResult.v = _mm512_permutexvar_ps(index, vec.v);
+}
+
+#endif
+
+//
+// Operations common to all native backends
+//
+
+inline int _cs149_cntbits(const __cs149_mask &maska) {
+  return __builtin_popcount(__cs149_lanes(maska));
+}
+
+inline void _cs149_vmove_float(__cs149_vec_float &dest, const __cs149_vec_float &src, const __cs149_mask &mask) {
+  dest.v = __cs149_blend(dest.v, src.v, mask);
+}
+inline void _cs149_vmove_int(__cs149_vec_int &dest, const __cs149_vec_int &src, const __cs149_mask &mask) {
+  dest.v = __cs149_blend(dest.v, src.v, mask);
+}
+
+// No SIMD integer divide: divide the active lanes one at a time
+inline void _cs149_vdiv_int(__cs149_vec_int &vecResult, const __cs149_vec_int &veca, const __cs149_vec_int &vecb, const __cs149_mask &mask) {
+  int lanes = __cs149_lanes(mask);
+  for (int i=0; i<VECTOR_WIDTH; i++) {
+    if (lanes & (1 << i)) vecResult.value[i] = veca.value[i] / vecb.value[i];
+  }
+}
+
+inline void addUserLog(const char * logStr) {}
+
+#endif
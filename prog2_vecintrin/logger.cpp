@@ -1,46 +1,347 @@
 #include "logger.h"
 #include "CS149intrin.h"
 
-void Logger::addLog(const char * instruction, __cs149_mask mask, int N) {
-  Log newLog;
-  strcpy(newLog.instruction, instruction);
-  newLog.mask = 0;
-  for (int i=0; i<N; i++) {
-    if (mask.value[i]) {
-      newLog.mask |= (((unsigned long long)1)<<i);
-      stats.utilized_lane++;
+// Spill records are written through a buffer of this many bytes
+#define SPILL_BUFFER_SIZE (1 << 16)
+
+// Spill file format: a sequence of records
+//   opcode (1 byte), N (1 byte), lane mask ((N+7)/8 bytes, little-endian)
+// where the first use of an opcode is preceded by its definition
+//   SPILL_DEFINE, opcode, name length, name
+#define SPILL_DEFINE 0xff
+
+// Default instruction costs in cycles, roughly those of the matching
+// AVX2 instructions on a recent x86 core: latency, issue interval and
+// whether the instruction drains the pipeline.  Loads, arithmetic and
+// compares pipeline; vdiv does not; cntbits is read by a branch.
+// hadd and interleave are shuffles that also cross lanes.
+static const OpcodeCost defaultCosts[] = {
+  { "vset",       1,  0.5, false },
+  { "vload",      5,  0.5, false },
+  { "vstore",     1,  1,   false },
+  { "vmove",      1,  0.5, false },
+  { "vadd",       4,  0.5, false },
+  { "vsub",       4,  0.5, false },
+  { "vmult",      4,  0.5, false },
+  { "vdiv",       11, 5,   false },
+  { "vabs",       1,  0.5, false },
+  { "vgt",        4,  1,   false },
+  { "vlt",        4,  1,   false },
+  { "veq",        4,  1,   false },
+  { "masknot",    1,  1,   false },
+  { "maskand",    1,  1,   false },
+  { "maskor",     1,  1,   false },
+  { "cntbits",    3,  1,   true  },
+  { "hadd",       6,  2,   false },
+  { "interleave", 3,  1,   false },
+  { "*",          1,  1,   false },
+};
+
+Logger::Logger() : mode(LOG_FULL), width(VECTOR_WIDTH), ringSize(0), ringNext(0), numLogged(0), numOpcodes(0), lastOpcode(-1),
+                   spillFile(NULL), costs(defaultCosts, defaultCosts + sizeof(defaultCosts) / sizeof(defaultCosts[0])),
+                   issueCycle(0), doneCycle(0) {
+  memset(&stats, 0, sizeof(stats));
+  spillName[0] = '\0';
+}
+
+Logger::~Logger() {
+  if (spillFile) {
+    flushSpill();
+    fclose(spillFile);
+  }
+}
+
+// Width of the vector unit being logged, for printStats and printLog
+void Logger::setWidth(int vectorWidth) {
+  width = vectorWidth;
+}
+
+// Forget everything logged so far, keeping the mode
+void Logger::reset() {
+  memset(&stats, 0, sizeof(stats));
+  numOpcodes = 0;
+  lastOpcode = -1;
+  numLogged = 0;
+  ringNext = 0;
+  issueCycle = doneCycle = 0;
+  log.clear();
+  if (spillFile) {
+    spillBuffer.clear();
+    spillFile = freopen(spillName, "wb", spillFile);
+    if (!spillFile) mode = LOG_STATS;
+  }
+}
+
+void Logger::setStatsOnly() {
+  mode = LOG_STATS;
+  log.clear();
+  log.shrink_to_fit();
+}
+
+void Logger::setRing(size_t entries) {
+  mode = LOG_RING;
+  ringSize = entries;
+  ringNext = 0;
+  log.clear();
+  log.reserve(entries);
+}
+
+bool Logger::setSpill(const char * filename) {
+  spillFile = fopen(filename, "wb");
+  if (!spillFile) return false;
+  mode = LOG_SPILL;
+  snprintf(spillName, sizeof(spillName), "%s", filename);
+  spillBuffer.reserve(SPILL_BUFFER_SIZE);
+  for (int i=0; i<numOpcodes; i++) {
+    spillDefine(i);
+  }
+  log.clear();
+  log.shrink_to_fit();
+  return true;
+}
+
+// Index in costs of instruction, or of the "*" entry if it has none
+int Logger::findCost(const char * instruction) {
+  int fallback = 0;
+  for (size_t i=0; i<costs.size(); i++) {
+    if (strcmp(costs[i].instruction, instruction) == 0) return i;
+    if (strcmp(costs[i].instruction, "*") == 0) fallback = i;
+  }
+  return fallback;
+}
+
+// Add or replace the cost of instruction
+void Logger::setCost(const char * instruction, double latency, double interval, bool drain) {
+  int i = findCost(instruction);
+  if (strcmp(costs[i].instruction, instruction) != 0) {
+    costs.push_back(OpcodeCost());
+    i = costs.size() - 1;
+    snprintf(costs[i].instruction, MAX_INST_LEN, "%s", instruction);
+  }
+  costs[i].latency = latency;
+  costs[i].interval = interval;
+  costs[i].drain = drain;
+  for (int j=0; j<numOpcodes; j++) {
+    opcodes[j].cost = findCost(opcodes[j].instruction);
+  }
+}
+
+// Read costs from a file of lines
+//   instruction latency interval [drain]
+// where drain is 0 or 1 and '#' starts a comment.  Instructions not in
+// the file keep their default cost.
+bool Logger::loadCostTable(const char * filename) {
+  FILE * fp = fopen(filename, "r");
+  if (!fp) return false;
+  char line[256];
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), fp)) {
+    char * comment = strchr(line, '#');
+    if (comment) *comment = '\0';
+    char instruction[MAX_INST_LEN];
+    double latency, interval;
+    int drain = 0;
+    int fields = sscanf(line, "%31s %lf %lf %d", instruction, &latency, &interval, &drain);
+    if (fields == EOF) continue;
+    if (fields < 3 || latency < 0 || interval < 0) {
+      printf("Bad cost table line: %s", line);
+      ok = false;
+    } else {
+      setCost(instruction, latency, interval, drain != 0);
+    }
+  }
+  fclose(fp);
+  return ok;
+}
+
+// In-order issue model: an instruction issues once the one before it
+// has, plus that one's issue interval, and a draining instruction also
+// waits until all earlier results are ready.  The logger does not see
+// which registers an instruction reads, so other dependences are not
+// modeled; the estimate is the cycle the last result is ready.
+void Logger::issue(OpcodeStats &op) {
+  const OpcodeCost &cost = costs[op.cost];
+  double start = issueCycle;
+  if (cost.drain && doneCycle > start) start = doneCycle;
+  op.cycles += start - issueCycle + cost.interval;
+  issueCycle = start + cost.interval;
+  if (start + cost.latency > doneCycle) doneCycle = start + cost.latency;
+}
+
+// Index in opcodes of instruction, added if new.  The intrinsics log
+// string literals, so when literal is set compare pointers first;
+// addUserLog strings may live in a reused buffer and are compared by
+// name.
+int Logger::findOpcode(const char * instruction, bool literal) {
+  if (literal && lastOpcode >= 0 && opcodes[lastOpcode].key == instruction) return lastOpcode;
+
+  for (int i=0; i<numOpcodes; i++) {
+    if ((literal && opcodes[i].key == instruction) ||
+        strncmp(opcodes[i].instruction, instruction, MAX_INST_LEN - 1) == 0) {
+      opcodes[i].key = instruction;
+      return lastOpcode = i;
     }
   }
+
+  if (numOpcodes == MAX_OPCODES) return lastOpcode = MAX_OPCODES - 1;
+  OpcodeStats &op = opcodes[numOpcodes];
+  op.key = instruction;
+  snprintf(op.instruction, MAX_INST_LEN, "%s", numOpcodes == MAX_OPCODES - 1 ? "(other)" : instruction);
+  memset(&op.stats, 0, sizeof(op.stats));
+  op.cost = findCost(op.instruction);
+  op.cycles = 0;
+  if (mode == LOG_SPILL) spillDefine(numOpcodes);
+  return lastOpcode = numOpcodes++;
+}
+
+void Logger::spillDefine(int opcode) {
+  int length = strlen(opcodes[opcode].instruction);
+  spillBuffer.push_back(SPILL_DEFINE);
+  spillBuffer.push_back(opcode);
+  spillBuffer.push_back(length);
+  spillBuffer.insert(spillBuffer.end(), opcodes[opcode].instruction, opcodes[opcode].instruction + length);
+}
+
+void Logger::spillRecord(int opcode, int N, unsigned long long mask) {
+  spillBuffer.push_back(opcode);
+  spillBuffer.push_back(N);
+  for (int i=0; i<N; i+=8) {
+    spillBuffer.push_back((mask >> i) & 0xff);
+  }
+  if (spillBuffer.size() > SPILL_BUFFER_SIZE - 64) flushSpill();
+}
+
+void Logger::flushSpill() {
+  fwrite(spillBuffer.data(), 1, spillBuffer.size(), spillFile);
+  fflush(spillFile);
+  spillBuffer.clear();
+}
+
+void Logger::addLog(const char * instruction, unsigned long long laneMask, int N) {
+  int active = __builtin_popcountll(laneMask);
+  stats.utilized_lane += active;
   stats.total_lane += N;
   stats.total_instructions += (N>0);
-  log.push_back(newLog);
+
+  // user logs have N == 0
+  int opcode = findOpcode(instruction, N > 0);
+  Statistics &opStats = opcodes[opcode].stats;
+  opStats.utilized_lane += active;
+  opStats.total_lane += N;
+  opStats.total_instructions += (N>0);
+  if (N > 0) issue(opcodes[opcode]);
+
+  if (mode == LOG_FULL || mode == LOG_RING) {
+    Log newLog;
+    if (opcode == MAX_OPCODES - 1) {
+      snprintf(newLog.instruction, MAX_INST_LEN, "%s", instruction);
+    } else {
+      memcpy(newLog.instruction, opcodes[opcode].instruction, MAX_INST_LEN);
+    }
+    newLog.mask = laneMask;
+    if (mode == LOG_FULL || log.size() < ringSize) {
+      log.push_back(newLog);
+    } else {
+      log[ringNext] = newLog;
+      if (++ringNext == ringSize) ringNext = 0;
+    }
+  } else if (mode == LOG_SPILL) {
+    spillRecord(opcode, N, laneMask);
+  }
+  numLogged++;
 }
 
 void Logger::printStats() {
   printf("****************** Printing Vector Unit Statistics *******************\n");
-  printf("Vector Width:              %d\n", VECTOR_WIDTH);
+  printf("Vector Width:              %d\n", width);
+#ifdef CS149_NATIVE
+  printf("Native %s backend: instructions are not logged\n", CS149_NATIVE);
+  return;
+#endif
   printf("Total Vector Instructions: %lld\n", stats.total_instructions);
   printf("Vector Utilization:        %.1f%%\n", (double)stats.utilized_lane/stats.total_lane*100);
   printf("Utilized Vector Lanes:     %lld\n", stats.utilized_lane);
   printf("Total Vector Lanes:        %lld\n", stats.total_lane);
-}
+  double cycles = estimatedCycles();
+  printf("Estimated Cycles:          %.0f\n", cycles);
 
+  printf(" Instruction | Count        Utilization  Latency  Interval  Est. Cycles\n");
+  for (int i=0; i<numOpcodes; i++) {
+    const Statistics &opStats = opcodes[i].stats;
+    if (opStats.total_instructions == 0) continue;
+    const OpcodeCost &cost = costs[opcodes[i].cost];
+    printf("%12s | %-12lld %5.1f%%      %7.1f  %8.2f%s %-12.0f (%.1f%%)\n", opcodes[i].instruction,
+           opStats.total_instructions, (double)opStats.utilized_lane/opStats.total_lane*100,
+           cost.latency, cost.interval, cost.drain ? "*" : " ", opcodes[i].cycles,
+           opcodes[i].cycles/cycles*100);
+  }
+  // results still in flight after the last instruction issues
+  if (doneCycle > issueCycle) {
+    printf("%12s | %-12s %6s      %7s  %8s  %-12.0f (%.1f%%)\n", "(drain)", "", "", "", "",
+           doneCycle - issueCycle, (doneCycle - issueCycle)/cycles*100);
+  }
+  printf("(* waits for earlier results; cycles from an in-order issue model)\n");
+}
 
+static void printLogEntry(const char * instruction, unsigned long long mask, int width) {
+  printf("%12s | ", instruction);
+  for (int j=0; j<width; j++) {
+    if (mask & (((unsigned long long)1)<<j)) {
+      printf("*");
+    } else {
+      printf("_");
+    }
+  }
+  printf("\n");
+}
 
 void Logger::printLog() {
   printf("***************** Printing Vector Unit Execution Log *****************\n");
+  if (mode == LOG_STATS) {
+    printf("Not kept: the logger is in statistics-only mode\n");
+    return;
+  }
+  if (mode == LOG_RING && numLogged > log.size()) {
+    printf("Last %zu of %llu instructions\n", log.size(), numLogged);
+  }
   printf(" Instruction | Vector Lane Occupancy ('*' for active, '_' for inactive)\n");
   printf("------------- --------------------------------------------------------\n");
-  for (int i=0; i<log.size(); i++) {
-    printf("%12s | ", log[i].instruction);
-    for (int j=0; j<VECTOR_WIDTH; j++) {
-      if (log[i].mask & (((unsigned long long)1)<<j)) {
-        printf("*");
-      } else {
-        printf("_");
+
+  if (mode == LOG_SPILL) {
+    // replay the spill file
+    flushSpill();
+    FILE * fp = fopen(spillName, "rb");
+    if (!fp) {
+      printf("Cannot read %s\n", spillName);
+      return;
+    }
+    char names[MAX_OPCODES][MAX_INST_LEN] = {};
+    int c;
+    while ((c = fgetc(fp)) != EOF) {
+      if (c == SPILL_DEFINE) {
+        int opcode = fgetc(fp);
+        int length = fgetc(fp);
+        if (opcode < 0 || opcode >= MAX_OPCODES || length < 0 || length >= MAX_INST_LEN ||
+            fread(names[opcode], 1, length, fp) != (size_t)length) break;
+        names[opcode][length] = '\0';
+        continue;
       }
+      int N = fgetc(fp);
+      if (c >= MAX_OPCODES || N == EOF) break;
+      unsigned long long mask = 0;
+      for (int i=0; i<N; i+=8) {
+        mask |= (unsigned long long)(fgetc(fp) & 0xff) << i;
+      }
+      printLogEntry(names[c], mask, width);
     }
-    printf("\n");
+    fclose(fp);
+    return;
   }
-}
 
+  // in ring mode the oldest entry is the next one to be overwritten
+  size_t first = mode == LOG_RING ? ringNext : 0;
+  for (size_t i=0; i<log.size(); i++) {
+    const Log &entry = log[(first + i) % log.size()];
+    printLogEntry(entry.instruction, entry.mask, width);
+  }
+}
@@ -8,7 +8,9 @@ using namespace std;
 
 #define MAX_INST_LEN 32
 
-struct __cs149_mask;
+// Distinct instruction names counted separately; later ones are
+// counted together as "(other)"
+#define MAX_OPCODES 64
 
 struct Log {
   char instruction[MAX_INST_LEN];
@@ -21,13 +23,76 @@ struct Statistics {
   unsigned long long total_instructions;
 };
 
+// Cost of one vector instruction, whatever the width, for the issue
+// model (see Logger::issue).  An instruction name of "*" gives the cost
+// of instructions the table does not list.
+struct OpcodeCost {
+  char instruction[MAX_INST_LEN];
+  double latency;   // cycles until its result can be used
+  double interval;  // cycles until the next instruction can issue
+  bool drain;       // waits for every earlier result, as cntbits does
+                    // when the program branches on it
+};
+
+// Per-opcode counts, kept in every mode
+struct OpcodeStats {
+  const char * key;  // the string last logged under this name
+  char instruction[MAX_INST_LEN];
+  Statistics stats;
+  int cost;          // index in Logger::costs
+  double cycles;     // issue and stall cycles spent on it
+};
+
+// What the logger keeps besides the statistics:
+//   LOG_FULL   every instruction, in memory (the default)
+//   LOG_STATS  nothing; printLog has nothing to print
+//   LOG_RING   the last ringSize instructions
+//   LOG_SPILL  every instruction, as binary records in a file that
+//              printLog reads back
+// All modes but LOG_FULL use constant memory however many
+// instructions are logged.
+enum LogMode { LOG_FULL, LOG_STATS, LOG_RING, LOG_SPILL };
+
 class Logger {
   private:
+    LogMode mode;
+    int width;
     vector<Log> log;
+    size_t ringSize;
+    size_t ringNext;  // ring slot the next instruction overwrites
+    unsigned long long numLogged;
     Statistics stats;
+    OpcodeStats opcodes[MAX_OPCODES];
+    int numOpcodes;
+    int lastOpcode;
+    FILE * spillFile;
+    char spillName[256];
+    vector<unsigned char> spillBuffer;
+    vector<OpcodeCost> costs;
+    double issueCycle;  // when the next instruction can issue
+    double doneCycle;   // when every issued result is ready
+
+    int findOpcode(const char * instruction, bool literal);
+    void spillDefine(int opcode);
+    void spillRecord(int opcode, int N, unsigned long long mask);
+    void flushSpill();
+    int findCost(const char * instruction);
+    void issue(OpcodeStats &op);
 
   public:
-    void addLog(const char * instruction, __cs149_mask mask, int N = 0);
+    Logger();
+    ~Logger();
+    void setStatsOnly();
+    void setRing(size_t entries);
+    bool setSpill(const char * filename);
+    void setWidth(int vectorWidth);
+    void reset();
+    const Statistics &getStats() const { return stats; }
+    void setCost(const char * instruction, double latency, double interval, bool drain);
+    bool loadCostTable(const char * filename);
+    double estimatedCycles() const { return issueCycle > doneCycle ? issueCycle : doneCycle; }
+    // laneMask has bit i set for each active lane i < N
+    void addLog(const char * instruction, unsigned long long laneMask, int N = 0);
     void printStats();
     void printLog();
 };
@@ -4,25 +4,75 @@
 #include <math.h>
 #include "CS149intrin.h"
 #include "logger.h"
+#include "CycleTimer.h"
 using namespace std;
 
 #define EXP_MAX 10
 
+// Widest vector --width accepts; the arrays are padded by this much
+#define MAX_VECTOR_WIDTH 64
+
 Logger CS149Logger;
 
 void usage(const char* progname);
+bool setLogMode(const char* mode);
+// Parse a --log-mode argument and configure CS149Logger
+bool setLogMode(const char* mode) {
+  if (strcmp(mode, "full") == 0) return true;
+  if (strcmp(mode, "stats") == 0) {
+    CS149Logger.setStatsOnly();
+    return true;
+  }
+  if (strncmp(mode, "ring:", 5) == 0) {
+    int entries = atoi(mode + 5);
+    if (entries <= 0) return false;
+    CS149Logger.setRing(entries);
+    return true;
+  }
+  if (strncmp(mode, "spill:", 6) == 0) {
+    if (!CS149Logger.setSpill(mode + 6)) {
+      printf("Error: Cannot open %s.\n", mode + 6);
+      return false;
+    }
+    return true;
+  }
+  return false;
+}
+
 void initValue(float* values, int* exponents, float* output, float* gold, unsigned int N);
 void absSerial(float* values, float* output, int N);
-void absVector(float* values, float* output, int N);
+template <int W> void absVector(float* values, float* output, int N);
 void clampedExpSerial(float* values, int* exponents, float* output, int N);
-void clampedExpVector(float* values, int* exponents, float* output, int N);
+template <int W> void clampedExpVector(float* values, int* exponents, float* output, int N);
 float arraySumSerial(float* values, int N);
-float arraySumVector(float* values, int N);
+template <int W> float arraySumVector(float* values, int N);
 bool verifyResult(float* values, int* exponents, float* output, float* gold, int N);
 
+// The vector kernels instantiated at one width
+struct VectorKernels {
+  int width;
+  void (*clampedExp)(float* values, int* exponents, float* output, int N);
+  float (*arraySum)(float* values, int N);
+};
+
+template <int W>
+VectorKernels kernelsFor() {
+  VectorKernels kernels = { W, clampedExpVector<W>, arraySumVector<W> };
+  return kernels;
+}
+
+bool selectKernels(int width, VectorKernels* kernels);
+void benchmark(const VectorKernels& kernels, float* values, int* exponents, float* output, int N, int runs);
+void microbenchmark(float* values, float* output, int N, int runs);
+void widthSweep(float* values, int* exponents, float* output, int N);
+
 int main(int argc, char * argv[]) {
   int N = 16;
   bool printLog = false;
+  int benchRuns = 0;
+  int microRuns = 0;
+  int width = VECTOR_WIDTH;
+  bool sweep = false;
 
   // 1. 解析命令行参数
   // parse commandline options ////////////////////////////////////////////
@@ -30,11 +80,17 @@ int main(int argc, char * argv[]) {
   static struct option long_options[] = {
     {"size", 1, 0, 's'},
     {"log", 0, 0, 'l'},
+    {"bench", 1, 0, 'b'},
+    {"micro", 1, 0, 'm'},
+    {"log-mode", 1, 0, 'L'},
+    {"width", 1, 0, 'W'},
+    {"width-sweep", 0, 0, 'S'},
+    {"cost-table", 1, 0, 'C'},
     {"help", 0, 0, '?'},
     {0 ,0, 0, 0}
   };
 
-  while ((opt = getopt_long(argc, argv, "s:l?", long_options, NULL)) != EOF) {
+  while ((opt = getopt_long(argc, argv, "s:lb:m:L:W:SC:?", long_options, NULL)) != EOF) {
 
     switch (opt) {
       case 's':
@@ -47,24 +103,65 @@ int main(int argc, char * argv[]) {
       case 'l':
         printLog = true;
         break;
+      case 'b':
+        benchRuns = atoi(optarg);
+        if (benchRuns <= 0) {
+          printf("Error: Benchmark run count is set to %d (<=0).\n", benchRuns);
+          return -1;
+        }
+        break;
+      case 'L':
+        if (!setLogMode(optarg)) {
+          printf("Error: Unknown log mode %s.\n", optarg);
+          return -1;
+        }
+        break;
+      case 'W':
+        width = atoi(optarg);
+        break;
+      case 'S':
+        sweep = true;
+        break;
+      case 'C':
+        if (!CS149Logger.loadCostTable(optarg)) {
+          printf("Error: Cannot read cost table %s.\n", optarg);
+          return -1;
+        }
+        break;
+      case 'm':
+        microRuns = atoi(optarg);
+        if (microRuns <= 0) {
+          printf("Error: Microbenchmark run count is set to %d (<=0).\n", microRuns);
+          return -1;
+        }
+        break;
       case '?':
       default:
         usage(argv[0]);
         return 1;
     }
   }
-
+  VectorKernels kernels;
+  if (!selectKernels(width, &kernels)) {
+#ifdef CS149_NATIVE
+    printf("Error: The native %s backend only runs at width %d.\n", CS149_NATIVE, VECTOR_WIDTH);
+#else
+    printf("Error: Vector width %d is not one of 2, 4, 8, 16, 32, 64.\n", width);
+#endif
+    return -1;
+  }
+  CS149Logger.setWidth(width);
 
   // 2. 初始化矢量
-  float* values = new float[N+VECTOR_WIDTH];
-  int* exponents = new int[N+VECTOR_WIDTH];
-  float* output = new float[N+VECTOR_WIDTH];
-  float* gold = new float[N+VECTOR_WIDTH];
+  float* values = new float[N+MAX_VECTOR_WIDTH];
+  int* exponents = new int[N+MAX_VECTOR_WIDTH];
+  float* output = new float[N+MAX_VECTOR_WIDTH];
+  float* gold = new float[N+MAX_VECTOR_WIDTH];
   initValue(values, exponents, output, gold, N);
 
   // 3. 执行 clampedExp 的串行版本和矢量化版本
   clampedExpSerial(values, exponents, gold, N);
-  clampedExpVector(values, exponents, output, N);
+  kernels.clampedExp(values, exponents, output, N);
 
   //absSerial(values, gold, N);
   //absVector(values, output, N);
@@ -85,9 +182,9 @@ int main(int argc, char * argv[]) {
 
   // 6. 打印 ARRAY SUM 的结果
   printf("\n\e[1;31mARRAY SUM\e[0m (bonus) \n");
-  if (N % VECTOR_WIDTH == 0) {
+  if (N % width == 0) {
     float sumGold = arraySumSerial(values, N);
-    float sumOutput = arraySumVector(values, N);
+    float sumOutput = kernels.arraySum(values, N);
     float epsilon = 0.1;
     bool sumCorrect = abs(sumGold - sumOutput) < epsilon * 2;
     if (!sumCorrect) {
@@ -97,9 +194,16 @@ int main(int argc, char * argv[]) {
       printf("Passed!!!\n");
     }
   } else {
-    printf("Must have N %% VECTOR_WIDTH == 0 for this problem (VECTOR_WIDTH is %d)\n", VECTOR_WIDTH);
+    printf("Must have N %% VECTOR_WIDTH == 0 for this problem (VECTOR_WIDTH is %d)\n", width);
   }
 
+  // 7. 如果指定了 --bench，测量串行版本和矢量版本的实际耗时
+  if (benchRuns > 0) benchmark(kernels, values, exponents, output, N, benchRuns);
+  if (microRuns > 0) microbenchmark(values, output, N, microRuns);
+
+  // 8. 如果指定了 --width-sweep，对每个矢量宽度统计指令数和利用率
+  if (sweep) widthSweep(values, exponents, output, N);
+
   delete [] values;
   delete [] exponents;
   delete [] output;
@@ -113,12 +217,24 @@ void usage(const char* progname) {
   printf("Program Options:\n");
   printf("  -s  --size <N>     Use workload size N (Default = 16)\n");
   printf("  -l  --log          Print vector unit execution log\n");
+  printf("  -b  --bench <R>    Time serial and vector versions, best of R runs\n");
+  printf("                     (build with 'make native' for real SIMD throughput)\n");
+  printf("  -L  --log-mode <M> What the logger keeps: full (default), stats, ring:<N> for the\n");
+  printf("                     last N instructions, or spill:<FILE> to stream them to FILE\n");
+  printf("  -m  --micro <R>    Time one kernel as hand-written lane loops and as intrinsics\n");
+  printf("                     with and without logging, best of R runs\n");
+  printf("  -W  --width <W>    Run the vector kernels W lanes wide: 2, 4, 8, 16, 32 or 64\n");
+  printf("                     (Default = %d; native backends only run at their own width)\n", VECTOR_WIDTH);
+  printf("  -S  --width-sweep  Print instruction count, utilization and estimated cycles\n");
+  printf("                     at every width\n");
+  printf("  -C  --cost-table <FILE>  Instruction costs for the cycle estimate, one\n");
+  printf("                     'instruction latency interval [drain]' line per instruction\n");
   printf("  -?  --help         This message\n");
 }
 
 void initValue(float* values, int* exponents, float* output, float* gold, unsigned int N) {
 
-  for (unsigned int i=0; i<N+VECTOR_WIDTH; i++)
+  for (unsigned int i=0; i<N+MAX_VECTOR_WIDTH; i++)
   {
     // random input values
     values[i] = -1.f + 4.f * static_cast<float>(rand()) / RAND_MAX;
@@ -132,7 +248,7 @@ void initValue(float* values, int* exponents, float* output, float* gold, unsign
 bool verifyResult(float* values, int* exponents, float* output, float* gold, int N) {
   int incorrect = -1;
   float epsilon = 0.00001;
-  for (int i=0; i<N+VECTOR_WIDTH; i++) {
+  for (int i=0; i<N+MAX_VECTOR_WIDTH; i++) {
     if ( abs(output[i] - gold[i]) > epsilon ) {
       incorrect = i;
       break;
@@ -168,6 +284,159 @@ bool verifyResult(float* values, int* exponents, float* output, float* gold, int
   return true;
 }
 
+// Best time in ms of runs calls to fn
+template <typename F>
+double bestOfRuns(int runs, F fn) {
+  double best = 1e30;
+  for (int r=0; r<runs; r++) {
+    double startTime = CycleTimer::currentSeconds();
+    fn();
+    best = min(best, CycleTimer::currentSeconds() - startTime);
+  }
+  return best * 1000;
+}
+
+// Time the serial and vector versions on the same input.  With an
+// emulated backend this measures the emulator; the native backends
+// (see CS149intrin_native.h) run the vector code on real SIMD registers.
+void benchmark(const VectorKernels& kernels, float* values, int* exponents, float* output, int N, int runs) {
+#ifdef CS149_NATIVE
+  printf("\n\e[1;31mBENCHMARK\e[0m (%s backend, VECTOR_WIDTH %d, N = %d)\n", CS149_NATIVE, kernels.width, N);
+#else
+  printf("\n\e[1;31mBENCHMARK\e[0m (emulated backend, VECTOR_WIDTH %d, N = %d)\n", kernels.width, N);
+#endif
+  double serial = bestOfRuns(runs, [&] { clampedExpSerial(values, exponents, output, N); });
+  double vector = bestOfRuns(runs, [&] { kernels.clampedExp(values, exponents, output, N); });
+  printf("[clampedExp serial]:\t\t[%.3f] ms\t[%.1f M elements/s]\n", serial, N / serial / 1000);
+  printf("[clampedExp vector]:\t\t[%.3f] ms\t[%.1f M elements/s]\t(%.2fx speedup)\n",
+         vector, N / vector / 1000, serial / vector);
+
+  if (N % kernels.width == 0) {
+    volatile float sink;
+    serial = bestOfRuns(runs, [&] { sink = arraySumSerial(values, N); });
+    vector = bestOfRuns(runs, [&] { sink = kernels.arraySum(values, N); });
+    (void)sink;
+    printf("[arraySum serial]:\t\t[%.3f] ms\t[%.1f M elements/s]\n", serial, N / serial / 1000);
+    printf("[arraySum vector]:\t\t[%.3f] ms\t[%.1f M elements/s]\t(%.2fx speedup)\n",
+           vector, N / vector / 1000, serial / vector);
+  }
+}
+
+#ifndef CS149_NATIVE
+// Microbenchmark kernel: output[i] = min(abs(values[i]) * 1.5, 3), as a
+// sequence of masked vector instructions.  Policy selects whether the
+// intrinsics log (see CS149intrin.h).
+template <typename Policy>
+void microKernelIntrinsics(float* values, float* output, int N) {
+  __cs149_vec_float x, result;
+  __cs149_vec_float scale = _cs149_vset_float<VECTOR_WIDTH, Policy>(1.5f);
+  __cs149_vec_float limit = _cs149_vset_float<VECTOR_WIDTH, Policy>(3.f);
+  __cs149_mask maskAll = _cs149_init_ones(), maskClamp;
+
+  for (int i=0; i+VECTOR_WIDTH <= N; i+=VECTOR_WIDTH) {
+    maskClamp = _cs149_init_ones(0);
+    _cs149_vload_float<Policy>(x, values+i, maskAll);
+    _cs149_vabs_float<Policy>(x, x, maskAll);
+    _cs149_vmult_float<Policy>(result, x, scale, maskAll);
+    _cs149_vgt_float<Policy>(maskClamp, result, limit, maskAll);
+    _cs149_vmove_float<Policy>(result, limit, maskClamp);
+    _cs149_vstore_float<Policy>(output+i, result, maskAll);
+  }
+}
+
+// The same instruction sequence written by hand, one loop over the
+// lanes per instruction
+void microKernelLoops(float* values, float* output, int N) {
+  float x[VECTOR_WIDTH], result[VECTOR_WIDTH];
+  bool clamp[VECTOR_WIDTH];
+
+  for (int i=0; i+VECTOR_WIDTH <= N; i+=VECTOR_WIDTH) {
+    for (int j=0; j<VECTOR_WIDTH; j++) clamp[j] = false;
+    for (int j=0; j<VECTOR_WIDTH; j++) x[j] = values[i+j];
+    for (int j=0; j<VECTOR_WIDTH; j++) x[j] = abs(x[j]);
+    for (int j=0; j<VECTOR_WIDTH; j++) result[j] = x[j] * 1.5f;
+    for (int j=0; j<VECTOR_WIDTH; j++) clamp[j] = result[j] > 3.f;
+    for (int j=0; j<VECTOR_WIDTH; j++) result[j] = clamp[j] ? 3.f : result[j];
+    for (int j=0; j<VECTOR_WIDTH; j++) output[i+j] = result[j];
+  }
+}
+#endif
+
+// Cost of the intrinsics layer: with CS149NoLog the inlined intrinsics
+// should run as fast as the hand-written loops; CS149Log adds the
+// logger.  Only meaningful for the emulated backend.
+void microbenchmark(float* values, float* output, int N, int runs) {
+#ifdef CS149_NATIVE
+  printf("\nMicrobenchmark needs the emulated backend (this is the native %s backend)\n", CS149_NATIVE);
+#else
+  printf("\n\e[1;31mMICROBENCHMARK\e[0m (VECTOR_WIDTH %d, N = %d)\n", VECTOR_WIDTH, N);
+  float* expected = new float[N];
+  double loops = bestOfRuns(runs, [&] { microKernelLoops(values, expected, N); });
+  double noLog = bestOfRuns(runs, [&] { microKernelIntrinsics<CS149NoLog>(values, output, N); });
+  bool matched = equal(expected, expected + N / VECTOR_WIDTH * VECTOR_WIDTH, output);
+  double log = bestOfRuns(runs, [&] { microKernelIntrinsics<CS149Log>(values, output, N); });
+  printf("[hand-written loops]:\t\t[%.3f] ms\n", loops);
+  printf("[intrinsics, no log]:\t\t[%.3f] ms\t(%.2fx loops)%s\n", noLog, noLog / loops,
+         matched ? "" : "\tOUTPUT MISMATCH");
+  printf("[intrinsics, log]:\t\t[%.3f] ms\t(%.2fx loops)\n", log, log / loops);
+  delete [] expected;
+#endif
+}
+
+// Kernels for a width of the vector unit.  The emulated backend runs
+// any of the widths instantiated here; a native backend only its own.
+bool selectKernels(int width, VectorKernels* kernels) {
+  switch (width) {
+#ifdef CS149_NATIVE
+    case VECTOR_WIDTH: *kernels = kernelsFor<VECTOR_WIDTH>(); return true;
+#else
+    case 2:  *kernels = kernelsFor<2>();  return true;
+    case 4:  *kernels = kernelsFor<4>();  return true;
+    case 8:  *kernels = kernelsFor<8>();  return true;
+    case 16: *kernels = kernelsFor<16>(); return true;
+    case 32: *kernels = kernelsFor<32>(); return true;
+    case 64: *kernels = kernelsFor<64>(); return true;
+#endif
+    default: return false;
+  }
+}
+
+// Log each kernel at every width and tabulate the instruction count,
+// lane utilization and estimated cycles.  The logger is reset before each run, so the
+// statistics printed before the sweep are not affected by what it
+// logs; arraySumVector only runs where the width divides N.
+void widthSweep(float* values, int* exponents, float* output, int N) {
+#ifdef CS149_NATIVE
+  printf("\nWidth sweep needs the emulated backend (this is the native %s backend)\n", CS149_NATIVE);
+#else
+  static const int widths[] = { 2, 4, 8, 16, 32, 64 };
+  printf("\n\e[1;31mWIDTH SWEEP\e[0m (N = %d)\n", N);
+  printf("       | clampedExp                            | arraySum\n");
+  printf(" Width | Instructions  Utilization  Est. Cycles | Instructions  Utilization  Est. Cycles\n");
+  for (int width : widths) {
+    VectorKernels kernels;
+    selectKernels(width, &kernels);
+    CS149Logger.setWidth(width);
+
+    CS149Logger.reset();
+    kernels.clampedExp(values, exponents, output, N);
+    Statistics exp = CS149Logger.getStats();
+    printf("%6d | %12lld %11.1f%% %12.0f |", width, exp.total_instructions,
+           (double)exp.utilized_lane/exp.total_lane*100, CS149Logger.estimatedCycles());
+
+    if (N % width == 0) {
+      CS149Logger.reset();
+      kernels.arraySum(values, N);
+      Statistics sum = CS149Logger.getStats();
+      printf(" %12lld %11.1f%% %12.0f\n", sum.total_instructions,
+             (double)sum.utilized_lane/sum.total_lane*100, CS149Logger.estimatedCycles());
+    } else {
+      printf(" %12s %12s %12s\n", "-", "-", "-");
+    }
+  }
+#endif
+}
+
 // computes the absolute value of all elements in the input array
 // values, stores result in output
 void absSerial(float* values, float* output, int N) {
@@ -183,22 +452,23 @@ void absSerial(float* values, float* output, int N) {
 
 
 // implementation of absSerial() above, but it is vectorized using CS149 intrinsics
+template <int W>
 void absVector(float* values, float* output, int N) {
-  __cs149_vec_float x;
-  __cs149_vec_float result;
-  __cs149_vec_float zero = _cs149_vset_float(0.f);
-  __cs149_mask maskAll, maskIsNegative, maskIsNotNegative;
+  __cs149_vec<float, W> x;
+  __cs149_vec<float, W> result;
+  __cs149_vec<float, W> zero = _cs149_vset_float<W>(0.f);
+  __cs149_vmask<W> maskAll, maskIsNegative, maskIsNotNegative;
 
 //  Note: Take a careful look at this loop indexing.  This example
 //  code is not guaranteed to work when (N % VECTOR_WIDTH) != 0.
 //  Why is that the case?
-  for (int i=0; i<N; i+=VECTOR_WIDTH) {
+  for (int i=0; i<N; i+=W) {
 
     // All ones
-    maskAll = _cs149_init_ones();
+    maskAll = _cs149_init_ones<W>();
 
     // All zeros
-    maskIsNegative = _cs149_init_ones(0);
+    maskIsNegative = _cs149_init_ones<W>(0);
 
     // Load vector of values from contiguous memory addresses
     _cs149_vload_float(x, values+i, maskAll);               // x = values[i];
@@ -246,6 +516,7 @@ void clampedExpSerial(float* values, int* exponents, float* output, int N) {
   }
 }
 
+template <int W>
 void clampedExpVector(float* values, int* exponents, float* output, int N) {
   //
   // CS149 STUDENTS TODO: Implement your vectorized version of
@@ -254,35 +525,35 @@ void clampedExpVector(float* values, int* exponents, float* output, int N) {
   // Your solution should work for any value of
   // N and VECTOR_WIDTH, not just when VECTOR_WIDTH divides N
   //
-  __cs149_vec_float x;
-  __cs149_vec_int   y;
-  __cs149_vec_float result;
-  __cs149_vec_int count;
-  __cs149_mask maskAll, maskFlag_if, maskFlag_while, maskFlag_if_2;
+  __cs149_vec<float, W> x;
+  __cs149_vec<int, W>   y;
+  __cs149_vec<float, W> result;
+  __cs149_vec<int, W> count;
+  __cs149_vmask<W> maskAll, maskFlag_if, maskFlag_while, maskFlag_if_2;
 
   // 全零矢量
-  __cs149_vec_int   zero_int   = _cs149_vset_int(0);
-  __cs149_vec_float zero_float = _cs149_vset_float(0.f);
+  __cs149_vec<int, W>   zero_int   = _cs149_vset_int<W>(0);
+  __cs149_vec<float, W> zero_float = _cs149_vset_float<W>(0.f);
   // 全1矢量
-  __cs149_vec_int   one_int    = _cs149_vset_int(1);
+  __cs149_vec<int, W>   one_int    = _cs149_vset_int<W>(1);
   // 全 9.999999f 矢量
-  __cs149_vec_float nine_float = _cs149_vset_float(9.999999f);
+  __cs149_vec<float, W> nine_float = _cs149_vset_float<W>(9.999999f);
   // 全 1.f 矢量
-  __cs149_vec_float one_float  = _cs149_vset_float(1.f);
+  __cs149_vec<float, W> one_float  = _cs149_vset_float<W>(1.f);
 
   // 全1掩码
-  maskAll = _cs149_init_ones();
+  maskAll = _cs149_init_ones<W>();
 
   // 对可以做并行的部分做并行
   int i;
-  for (i=0; i+VECTOR_WIDTH <= N; i+=VECTOR_WIDTH) {
+  for (i=0; i+W <= N; i+=W) {
 
     // 用来处理分支判断语句的掩码，初始化为全 0
-    maskFlag_if = _cs149_init_ones(0);
+    maskFlag_if = _cs149_init_ones<W>(0);
     // 用来处理循环判断语句的掩码，初始化为全 0
-    maskFlag_while = _cs149_init_ones(0);
+    maskFlag_while = _cs149_init_ones<W>(0);
     // 用来处理内部分支判断语句的掩码，初始化为全 0
-    maskFlag_if_2 = _cs149_init_ones(0);
+    maskFlag_if_2 = _cs149_init_ones<W>(0);
 
     _cs149_vload_float(x, values+i, maskAll);                               // float x = values[i];
     _cs149_vload_int(y, exponents+i, maskAll);                              // int y = exponents[i];
@@ -332,21 +603,22 @@ float arraySumSerial(float* values, int N) {
 // returns the sum of all elements in values
 // You can assume N is a multiple of VECTOR_WIDTH
 // You can assume VECTOR_WIDTH is a power of 2
+template <int W>
 float arraySumVector(float* values, int N) {
   
   //
   // CS149 STUDENTS TODO: Implement your vectorized version of arraySumSerial here
   //
-  __cs149_vec_float sum = _cs149_vset_float(0.f);
-  __cs149_vec_float vector_values;
-  __cs149_mask maskAll = _cs149_init_ones();
+  __cs149_vec<float, W> sum = _cs149_vset_float<W>(0.f);
+  __cs149_vec<float, W> vector_values;
+  __cs149_vmask<W> maskAll = _cs149_init_ones<W>();
   float output = 0.f;
   
-  for (int i=0; i+VECTOR_WIDTH <= N; i+=VECTOR_WIDTH) {
+  for (int i=0; i+W <= N; i+=W) {
     _cs149_vload_float(vector_values, values+i, maskAll);               // x = values[i];
     _cs149_vadd_float(sum, sum, vector_values, maskAll);
   }
-  int i = VECTOR_WIDTH;
+  int i = W;
   while (i /= 2) {
     _cs149_hadd_float(sum, sum);
     _cs149_interleave_float(sum, sum);
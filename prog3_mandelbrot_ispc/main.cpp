@@ -1,8 +1,16 @@
 #include <stdio.h>
+#include <string.h>
 #include <algorithm>
+#include <thread>
+#include <vector>
 #include <getopt.h>
 
 #include "CycleTimer.h"
+#include "deepZoom.h"
+#include "ispcTarget.h"
+#include "panCache.h"
+#include "progressive.h"
+#include "tileLayout.h"
 #include "mandelbrot_ispc.h"
 
 extern void mandelbrotSerial(
@@ -12,6 +20,33 @@ extern void mandelbrotSerial(
     int maxIterations,
     int output[]);
 
+extern void mandelbrotSerialEarlyOut(
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int startRow, int numRows,
+    int maxIterations,
+    int output[]);
+
+extern void mandelbrotSerialMariani(
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int startRow, int numRows,
+    int maxIterations,
+    int output[]);
+
+extern void mandelbrotSerialPass(
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int startRow, int numRows,
+    int step,
+    int maxIterations,
+    int output[]);
+
+extern void mandelbrotSerialDeep(
+    const DeepFrame& frame,
+    int maxIterations,
+    int output[]);
+
 extern void mandelbrotThread(
     int numThreads,
     float x0, float y0, float x1, float y1,
@@ -25,14 +60,41 @@ extern void writePPMImage(
     const char *filename,
     int maxIterations);
 
+extern FILE* beginPPMImage(
+    const char *filename,
+    int width, int height);
+
+extern void writePPMRows(
+    FILE *fp,
+    const int* data,
+    int width, int numRows,
+    int maxIterations);
+
+extern void endPPMImage(
+    FILE *fp,
+    const char *filename);
+
+extern void writePPMImageTiled(
+    int* data,
+    int width, int height,
+    int tileWidth, int tileHeight,
+    const char *filename,
+    int maxIterations);
+
+extern void writePPMHeatmap(
+    const float* values,
+    int width, int height,
+    const char *filename);
+
 bool verifyResult (int *gold, int *result, int width, int height) {
     int i, j;
 
     for (i = 0; i < height; i++) {
         for (j = 0; j < width; j++) {
-            if (gold[i * width + j] != result[i * width + j]) {
+            size_t index = (size_t)i * width + j;
+            if (gold[index] != result[index]) {
                 printf ("Mismatch : [%d][%d], Expected : %d, Actual : %d\n",
-                            i, j, gold[i * width + j], result[i * width + j]);
+                            i, j, gold[index], result[index]);
                 return 0;
             }
         }
@@ -58,6 +120,23 @@ scaleAndShift(float& x0, float& x1, float& y0, float& y1,
 
 }
 
+//
+// setViewport --
+//
+// Make [x0, x1] x [y0, y1] the viewport of height scale centered on
+// (centerX, centerY), with the width chosen so pixels are square.
+void setViewport(float& x0, float& x1, float& y0, float& y1,
+                 float centerX, float centerY, float scale,
+                 int width, int height)
+{
+    float halfHeight = 0.5f * scale;
+    float halfWidth = halfHeight * width / height;
+    x0 = centerX - halfWidth;
+    x1 = centerX + halfWidth;
+    y0 = centerY - halfHeight;
+    y1 = centerY + halfHeight;
+}
+
 using namespace ispc;
 
 void usage(const char* progname) {
@@ -65,16 +144,716 @@ void usage(const char* progname) {
     printf("Program Options:\n");
     printf("  -t  --tasks        Run ISPC code implementation with tasks\n");
     printf("  -v  --view <INT>   Use specified view settings\n");
+    printf("  -k  --tasks-per-core <N>  Tasks launched per core by the task version (Default = 8)\n");
+    printf("  -K  --task-sweep   Print task-version speedup for 2, 4, 8, ... 1024 tasks\n");
+    printf("  -T  --tile <WxH>   Also run the tiled task version with WxH tiles (e.g. 32x32, 64x16)\n");
+    printf("  -L  --tiled-layout Store each tile contiguously in the tiled version's output\n");
+    printf("  -e  --early-out    Also run cardioid/bulb + periodicity early-out versions\n");
+    printf("  -m  --mariani      Also run Mariani-Silver subdivision versions\n");
+    printf("  -W  --width <N>    Image width in pixels (Default = 1200)\n");
+    printf("  -H  --height <N>   Image height in pixels (Default = 800)\n");
+    printf("  -i  --iters <N>    Maximum iterations per pixel (Default = 256)\n");
+    printf("  -c  --center <X,Y> Center the viewport on X+Yi\n");
+    printf("  -z  --scale <S>    Viewport height in the complex plane; width follows the aspect ratio\n");
+    printf("  -r  --repeat <N>   Time the best of N runs (Default = 3)\n");
+    printf("  -S  --stream <ROWS> Stream the image to mandelbrot-stream.ppm in bands of ROWS rows\n");
+    printf("                     rendered with ISPC tasks, without holding it in memory\n");
+    printf("  -P  --progressive  Render 1/8, 1/4, 1/2 and full resolution passes serially and\n");
+    printf("                     with ISPC tasks, reporting time to first pass and to final image\n");
+    printf("  -n  --pan <FRAMES> Pan across FRAMES frames and compare the frame cache with full recompute\n");
+    printf("  -I  --isa <TARGET> Run the ISPC code built for TARGET (needs 'make targets'):\n");
+    printf("                     sse4-i32x4, avx2-i32x8, avx2-i32x16 or avx512skx-i32x16\n");
+    printf("  -u  --lane-profile Run the instrumented ISPC kernel and report SIMD lane utilization\n");
+    printf("                     per iteration, gang, task and tile, with a heatmap image\n");
+    printf("  -o  --reorder      Compare the plain ISPC kernel with cost-sorted pixel order and\n");
+    printf("                     lane refilling on views 1 and 2\n");
+    printf("  -a  --batch <FRAMES> Render a FRAMES-frame zoom with one task launch per batch and\n");
+    printf("                     compare frames/s with calling the task version per frame\n");
+    printf("  -D  --deep         Render by double-precision perturbation (zooms down to ~1e-300);\n");
+    printf("                     --center is read to ~32 significant digits\n");
     printf("  -?  --help         This message\n");
 }
 
 
+//
+// taskCount --
+//
+// Number of tasks for mandelbrot_ispc_withtasks: tasksPerCore tasks per
+// hardware thread, but no more than one per row.
+int taskCount(int tasksPerCore, int height)
+{
+    int cores = std::max(1, (int)std::thread::hardware_concurrency());
+    return std::max(1, std::min(tasksPerCore * cores, height));
+}
+
+//
+// sweepTaskCounts --
+//
+// Time mandelbrot_ispc_withtasks with 2, 4, 8, ... 1024 tasks and print
+// the speedup of each over the serial time, so the granularity can be
+// picked per machine.  Every output is checked against gold.  Returns
+// false on a mismatch.
+bool sweepTaskCounts(float x0, float y0, float x1, float y1, int width, int height,
+                     int maxIterations, int repeat, int* gold, double minSerial)
+{
+    std::vector<int> output((size_t)width * height);
+    for (int numTasks = 2; numTasks <= 1024; numTasks *= 2) {
+        double minTime = 1e30;
+        for (int i = 0; i < repeat; ++i) {
+            double startTime = CycleTimer::currentSeconds();
+            mandelbrot_ispc_withtasks(x0, y0, x1, y1, width, height, maxIterations, numTasks,
+                                      output.data());
+            minTime = std::min(minTime, CycleTimer::currentSeconds() - startTime);
+        }
+        if (! verifyResult (gold, output.data(), width, height)) {
+            printf ("Error : ISPC output with %d tasks differs from sequential output\n", numTasks);
+            return false;
+        }
+        printf("[%4d tasks]:\t\t\t[%.3f] ms\t(%.2fx speedup)\n",
+               numTasks, minTime * 1000, minSerial / minTime);
+    }
+    return true;
+}
+
+//
+// renderDeepZoom --
+//
+// Deep-zoom version of the benchmark: compute the reference orbit of
+// the view center, then render by perturbation serially, with ISPC and
+// (with useTasks) with ISPC tasks, checking the ISPC output against
+// the serial output.  Returns the process exit status.
+int renderDeepZoom(DoubleDouble centerX, DoubleDouble centerY, double scale,
+                   int width, int height, int maxIterations,
+                   bool useTasks, int repeat)
+{
+    DeepFrame frame;
+    double startTime = CycleTimer::currentSeconds();
+    prepareDeepFrame(centerX, centerY, scale, width, height, maxIterations, &frame);
+    double refTime = CycleTimer::currentSeconds() - startTime;
+
+    printf("Deep zoom at %.17g%+.17gi, scale %g (%g per pixel)\n",
+           centerX.hi, centerY.hi, scale, frame.pixelSize);
+    printf("[deep reference orbit]:\t\t[%.3f] ms (%d iterations%s)\n",
+           refTime * 1000, frame.refLength, frame.refLength < maxIterations ? ", escaped" : "");
+
+    size_t numPixels = (size_t)width * height;
+    std::vector<int> output_serial(numPixels);
+    std::vector<int> output_ispc(numPixels);
+
+    double minSerial = 1e30;
+    for (int i = 0; i < repeat; ++i) {
+        startTime = CycleTimer::currentSeconds();
+        mandelbrotSerialDeep(frame, maxIterations, output_serial.data());
+        minSerial = std::min(minSerial, CycleTimer::currentSeconds() - startTime);
+    }
+    printf("[deep serial]:\t\t\t[%.3f] ms\n", minSerial * 1000);
+
+    double minISPC = 1e30;
+    for (int i = 0; i < repeat; ++i) {
+        startTime = CycleTimer::currentSeconds();
+        mandelbrot_ispc_deep(width, height, frame.deltaX0, frame.deltaY0, frame.pixelSize,
+                             frame.refLength, frame.refRe.data(), frame.refIm.data(),
+                             maxIterations, output_ispc.data());
+        minISPC = std::min(minISPC, CycleTimer::currentSeconds() - startTime);
+    }
+    printf("[deep ispc]:\t\t\t[%.3f] ms\n", minISPC * 1000);
+    if (! verifyResult (output_serial.data(), output_ispc.data(), width, height)) {
+        printf ("Error : ISPC deep-zoom output differs from sequential output\n");
+        return 1;
+    }
+
+    double minTaskISPC = 1e30;
+    if (useTasks) {
+        for (int i = 0; i < repeat; ++i) {
+            startTime = CycleTimer::currentSeconds();
+            mandelbrot_ispc_deep_withtasks(width, height, frame.deltaX0, frame.deltaY0, frame.pixelSize,
+                                           frame.refLength, frame.refRe.data(), frame.refIm.data(),
+                                           maxIterations, output_ispc.data());
+            minTaskISPC = std::min(minTaskISPC, CycleTimer::currentSeconds() - startTime);
+        }
+        printf("[deep multicore ispc]:\t\t[%.3f] ms (%.1f frames/s)\n",
+               minTaskISPC * 1000, 1.0 / (minTaskISPC + refTime));
+        if (! verifyResult (output_serial.data(), output_ispc.data(), width, height)) {
+            printf ("Error : ISPC deep-zoom output differs from sequential output\n");
+            return 1;
+        }
+    }
+    writePPMImage(output_ispc.data(), width, height, "mandelbrot-deep-ispc.ppm", maxIterations);
+
+    printf("\t\t\t\t(%.2fx speedup from ISPC)\n", minSerial/minISPC);
+    if (useTasks)
+        printf("\t\t\t\t(%.2fx speedup from task ISPC)\n", minSerial/minTaskISPC);
+
+    return 0;
+}
+
+// 不超过这个像素数的流式输出会再和完整的串行结果对比一次
+// Streamed images up to this many pixels are also checked against a
+// full-size serial render.
+static const size_t STREAM_VERIFY_PIXELS = (size_t)1 << 26;
+
+//
+// streamImage --
+//
+// Render the image one band of bandRows rows at a time with ISPC tasks
+// and append each band to the PPM file, so memory use is one band
+// regardless of image height.  Small images are checked band by band
+// against a full serial render.  Returns the process exit status.
+int streamImage(float x0, float y0, float x1, float y1,
+                int width, int height, int maxIterations, int bandRows)
+{
+    const char* filename = "mandelbrot-stream.ppm";
+    size_t numPixels = (size_t)width * height;
+    bool verify = numPixels <= STREAM_VERIFY_PIXELS;
+
+    std::vector<int> gold;
+    if (verify) {
+        gold.resize(numPixels);
+        mandelbrotSerial(x0, y0, x1, y1, width, height, 0, height, maxIterations, gold.data());
+    }
+
+    std::vector<int> band((size_t)bandRows * width);
+    FILE* fp = beginPPMImage(filename, width, height);
+    double renderTime = 0.0;
+    double startTime = CycleTimer::currentSeconds();
+    for (int startRow = 0; startRow < height; startRow += bandRows) {
+        int numRows = std::min(bandRows, height - startRow);
+
+        double bandStart = CycleTimer::currentSeconds();
+        mandelbrot_ispc_band_withtasks(x0, y0, x1, y1, width, height, startRow, numRows,
+                                       maxIterations, band.data());
+        renderTime += CycleTimer::currentSeconds() - bandStart;
+
+        if (verify && ! verifyResult (gold.data() + (size_t)startRow * width, band.data(), width, numRows)) {
+            printf ("Error : Streamed ISPC output differs from sequential output\n");
+            fclose(fp);
+            return 1;
+        }
+        writePPMRows(fp, band.data(), width, numRows, maxIterations);
+    }
+    double endTime = CycleTimer::currentSeconds();
+    endPPMImage(fp, filename);
+
+    printf("[mandelbrot stream ispc]:\t[%.3f] ms (%.3f ms rendering, %d-row bands, %.1f MB)\n",
+           (endTime - startTime) * 1000, renderTime * 1000, bandRows,
+           (double)band.size() * sizeof(int) / (1024 * 1024));
+    if (!verify)
+        printf("\t\t\t\t(image too large to verify against a serial render)\n");
+    return 0;
+}
+
+// 渐进式渲染时每次 launch 的行数，两次 launch 之间检查取消请求
+// Rows per ISPC launch in progressive mode; cancellation is checked
+// between launches.
+static const int PROGRESSIVE_BAND_ROWS = 64;
+
+void printPass(int step, const int*, double elapsedSeconds)
+{
+    printf("\t\t\t\t  1/%d pass done at [%.3f] ms\n", step, elapsedSeconds * 1000);
+}
+
+//
+// ispcPass --
+//
+// One progressive pass with ISPC tasks, launched in bands of
+// PROGRESSIVE_BAND_ROWS rows.  Returns false if cancel was set.
+bool ispcPass(float x0, float y0, float x1, float y1, int width, int height,
+              int maxIterations, int step, int output[], const CancelToken* cancel)
+{
+    for (int startRow = 0; startRow < height; startRow += PROGRESSIVE_BAND_ROWS) {
+        if (cancel && cancel->cancelled())
+            return false;
+        int numRows = std::min(PROGRESSIVE_BAND_ROWS, height - startRow);
+        mandelbrot_ispc_pass_withtasks(x0, y0, x1, y1, width, height, startRow, numRows,
+                                       step, maxIterations, output);
+    }
+    return true;
+}
+
+//
+// runProgressive --
+//
+// Render pass by pass serially and with ISPC tasks, check both final
+// images against the plain serial render, then cancel an ISPC render
+// right after its first pass.  Returns the process exit status.
+int runProgressive(float x0, float y0, float x1, float y1,
+                   int width, int height, int maxIterations)
+{
+    size_t numPixels = (size_t)width * height;
+    std::vector<int> gold(numPixels);
+    std::vector<int> output(numPixels);
+
+    double startTime = CycleTimer::currentSeconds();
+    mandelbrotSerial(x0, y0, x1, y1, width, height, 0, height, maxIterations, gold.data());
+    printf("[mandelbrot serial]:\t\t[%.3f] ms\n", (CycleTimer::currentSeconds() - startTime) * 1000);
+
+    ProgressiveTimes times;
+    renderProgressive([&](int step) {
+            mandelbrotSerialPass(x0, y0, x1, y1, width, height, 0, height, step, maxIterations, output.data());
+            return true;
+        }, output.data(), printPass, NULL, &times);
+    printf("[progressive serial]:\t\t[first pass %.3f] [final %.3f] ms\n",
+           times.firstPass * 1000, times.final * 1000);
+    if (! verifyResult (gold.data(), output.data(), width, height)) {
+        printf ("Error : Progressive serial output differs from sequential output\n");
+        return 1;
+    }
+
+    std::fill(output.begin(), output.end(), 0);
+    renderProgressive([&](int step) {
+            return ispcPass(x0, y0, x1, y1, width, height, maxIterations, step, output.data(), NULL);
+        }, output.data(), printPass, NULL, &times);
+    printf("[progressive ispc tasks]:\t[first pass %.3f] [final %.3f] ms\n",
+           times.firstPass * 1000, times.final * 1000);
+    writePPMImage(output.data(), width, height, "mandelbrot-progressive.ppm", maxIterations);
+    if (! verifyResult (gold.data(), output.data(), width, height)) {
+        printf ("Error : Progressive ISPC output differs from sequential output\n");
+        return 1;
+    }
+
+    // 第一遍完成后立即到来新的视口请求
+    CancelToken cancel;
+    startTime = CycleTimer::currentSeconds();
+    bool completed = renderProgressive([&](int step) {
+            return ispcPass(x0, y0, x1, y1, width, height, maxIterations, step, output.data(), &cancel);
+        }, output.data(), [&cancel](int, const int*, double) { cancel.cancel(); }, &cancel, &times);
+    printf("[progressive cancelled]:\t[%.3f] ms (%s after the 1/%d pass)\n",
+           (CycleTimer::currentSeconds() - startTime) * 1000,
+           completed ? "not stopped" : "stopped", times.lastStep);
+
+    return 0;
+}
+
+// --pan 动画每帧平移的像素数
+// Pan per frame of the --pan animation, in pixels.
+static const int PAN_STEP_X = 6;
+static const int PAN_STEP_Y = 2;
+
+// Render rects of the cached frame with ISPC tasks.
+void ispcRects(const PanCache& cache, int width, int height, int maxIterations,
+               const PanRect rects[], int numRects, int output[])
+{
+    for (int r = 0; r < numRects; r++)
+        mandelbrot_ispc_rect_withtasks(cache.anchorX0(), cache.anchorY0(),
+                                       cache.anchorX1(), cache.anchorY1(), width, height,
+                                       cache.colOffset(), cache.rowOffset(),
+                                       rects[r].x, rects[r].y, rects[r].width, rects[r].height,
+                                       maxIterations, output);
+}
+
+//
+// runPanAnimation --
+//
+// Move the viewport by (PAN_STEP_X, PAN_STEP_Y) pixels per frame and
+// render every frame with ISPC tasks twice: through a PanCache, which
+// computes only the exposed strips, and in full on the same pixel grid.
+// The two must agree.  Returns the process exit status.
+int runPanAnimation(float x0, float y0, float x1, float y1,
+                    int width, int height, int maxIterations, int numFrames)
+{
+    float dx = (x1 - x0) / width;
+    float dy = (y1 - y0) / height;
+
+    PanCache cache;
+    std::vector<int> full((size_t)width * height);
+    double cachedTime = 0.0, fullTime = 0.0;
+    size_t cachedPixels = 0;
+
+    for (int frame = 0; frame < numFrames; frame++) {
+        float fx0 = x0 + frame * PAN_STEP_X * dx;
+        float fy0 = y0 + frame * PAN_STEP_Y * dy;
+
+        PanRect rects[2];
+        double startTime = CycleTimer::currentSeconds();
+        int numRects = cache.update(fx0, fy0, fx0 + (x1 - x0), fy0 + (y1 - y0), width, height, rects);
+        ispcRects(cache, width, height, maxIterations, rects, numRects, cache.frame());
+        cachedTime += CycleTimer::currentSeconds() - startTime;
+        for (int r = 0; r < numRects; r++)
+            cachedPixels += (size_t)rects[r].width * rects[r].height;
+
+        PanRect whole = { 0, 0, width, height };
+        startTime = CycleTimer::currentSeconds();
+        ispcRects(cache, width, height, maxIterations, &whole, 1, full.data());
+        fullTime += CycleTimer::currentSeconds() - startTime;
+
+        if (! verifyResult (full.data(), cache.frame(), width, height)) {
+            printf ("Error : Cached frame %d differs from full recompute\n", frame);
+            return 1;
+        }
+    }
+
+    printf("[pan full recompute]:\t\t[%.3f] ms per frame (%.1f frames/s)\n",
+           fullTime * 1000 / numFrames, numFrames / fullTime);
+    printf("[pan frame cache]:\t\t[%.3f] ms per frame (%.1f frames/s, %.1f%% of pixels computed)\n",
+           cachedTime * 1000 / numFrames, numFrames / cachedTime,
+           100.0 * cachedPixels / ((double)width * height * numFrames));
+    printf("\t\t\t\t(%.2fx speedup from frame cache)\n", fullTime / cachedTime);
+    writePPMImage(cache.frame(), width, height, "mandelbrot-pan.ppm", maxIterations);
+    return 0;
+}
+
+// 剖析时每个任务的行数，以及汇总统计用的 tile 边长
+// Rows per task of the profiling kernel, and the tile size used to
+// summarize lane utilization.
+static const int PROFILE_ROWS_PER_TASK = 4;
+static const int PROFILE_TILE_SIZE = 64;
+
+static double efficiency(long long laneSteps, long long gangSteps, int gangSize)
+{
+    return gangSteps > 0 ? (double)laneSteps / ((double)gangSteps * gangSize) : 1.0;
+}
+
+// Print the worst, median and best efficiency of a set of tasks or
+// tiles, skipping empty ones; worst and best are followed by their index.
+static void printEfficiencySpread(const std::vector<long long>& gangSteps,
+                                  const std::vector<long long>& laneSteps, int gangSize)
+{
+    std::vector<std::pair<double, int>> e;
+    for (size_t k = 0; k < gangSteps.size(); k++)
+        if (gangSteps[k] > 0)
+            e.push_back(std::make_pair(efficiency(laneSteps[k], gangSteps[k], gangSize), (int)k));
+    if (e.empty()) {
+        printf("-\n");
+        return;
+    }
+    std::sort(e.begin(), e.end());
+    printf("worst %.1f%% (#%d), median %.1f%%, best %.1f%% (#%d)\n",
+           e.front().first * 100, e.front().second, e[e.size() / 2].first * 100,
+           e.back().first * 100, e.back().second);
+}
+
+//
+// runLaneProfile --
+//
+// Render with the instrumented ISPC kernel and report how well the
+// gang's lanes are used: overall, as a histogram of active lanes per
+// loop iteration, and per task and PROFILE_TILE_SIZE tile (worst,
+// median, best).  Writes the image and a heatmap of the SIMD efficiency
+// of the gang that computed each pixel.  Returns the process exit status.
+int runLaneProfile(float x0, float y0, float x1, float y1,
+                   int width, int height, int maxIterations)
+{
+    int gangSize = mandelbrot_ispc_gang_size();
+    int gangsPerRow = (width + gangSize - 1) / gangSize;
+    int numTasks = (height + PROFILE_ROWS_PER_TASK - 1) / PROFILE_ROWS_PER_TASK;
+    size_t numPixels = (size_t)width * height;
+    size_t numGangs = (size_t)gangsPerRow * height;
+
+    std::vector<int> gold(numPixels), output(numPixels);
+    std::vector<int64_t> gangSteps(numGangs), laneSteps(numGangs);
+    std::vector<int64_t> histograms((size_t)numTasks * (gangSize + 1), 0);
+
+    mandelbrotSerial(x0, y0, x1, y1, width, height, 0, height, maxIterations, gold.data());
+
+    double startTime = CycleTimer::currentSeconds();
+    mandelbrot_ispc_profile_withtasks(x0, y0, x1, y1, width, height, PROFILE_ROWS_PER_TASK,
+                                      maxIterations, output.data(), gangSteps.data(),
+                                      laneSteps.data(), histograms.data());
+    double endTime = CycleTimer::currentSeconds();
+    printf("[mandelbrot profiled ispc]:\t[%.3f] ms\n", (endTime - startTime) * 1000);
+
+    if (! verifyResult (gold.data(), output.data(), width, height)) {
+        printf ("Error : Profiled ISPC output differs from sequential output\n");
+        return 1;
+    }
+
+    // 按任务和按 tile 汇总
+    int tilesX = (width + PROFILE_TILE_SIZE - 1) / PROFILE_TILE_SIZE;
+    int tilesY = (height + PROFILE_TILE_SIZE - 1) / PROFILE_TILE_SIZE;
+    std::vector<long long> taskGang(numTasks, 0), taskLane(numTasks, 0);
+    std::vector<long long> tileGang((size_t)tilesX * tilesY, 0), tileLane((size_t)tilesX * tilesY, 0);
+    std::vector<float> heatmap(numPixels);
+    long long totalGang = 0, totalLane = 0;
+
+    for (int j = 0; j < height; j++) {
+        for (int g = 0; g < gangsPerRow; g++) {
+            size_t gang = (size_t)j * gangsPerRow + g;
+            long long gs = gangSteps[gang], ls = laneSteps[gang];
+            totalGang += gs;
+            totalLane += ls;
+            taskGang[j / PROFILE_ROWS_PER_TASK] += gs;
+            taskLane[j / PROFILE_ROWS_PER_TASK] += ls;
+
+            // gangs never straddle tiles: the tile size is a multiple
+            // of every gang size
+            size_t tile = (size_t)(j / PROFILE_TILE_SIZE) * tilesX + g * gangSize / PROFILE_TILE_SIZE;
+            tileGang[tile] += gs;
+            tileLane[tile] += ls;
+
+            float e = (float)efficiency(ls, gs, gangSize);
+            int iend = std::min((g + 1) * gangSize, width);
+            for (int i = g * gangSize; i < iend; i++)
+                heatmap[(size_t)j * width + i] = e;
+        }
+    }
+
+    std::vector<long long> histogram(gangSize + 1, 0);
+    for (int t = 0; t < numTasks; t++)
+        for (int k = 0; k <= gangSize; k++)
+            histogram[k] += histograms[(size_t)t * (gangSize + 1) + k];
+
+    printf("****************** ISPC Lane Utilization Statistics ******************\n");
+    printf("Gang Size:                 %d\n", gangSize);
+    printf("Gang Loop Iterations:      %lld\n", totalGang);
+    printf("SIMD Efficiency:           %.1f%%\n", efficiency(totalLane, totalGang, gangSize) * 100);
+    printf("Utilized Lane Iterations:  %lld\n", totalLane);
+    printf("Total Lane Iterations:     %lld\n", totalGang * gangSize);
+    printf("Active lanes per loop iteration:\n");
+    for (int k = 1; k <= gangSize; k++)
+        printf("  %2d lanes: %5.1f%%\n", k, totalGang ? 100.0 * histogram[k] / totalGang : 0.0);
+
+    printf("Per task (%d rows):         ", PROFILE_ROWS_PER_TASK);
+    printEfficiencySpread(taskGang, taskLane, gangSize);
+    printf("Per %dx%d tile:            ", PROFILE_TILE_SIZE, PROFILE_TILE_SIZE);
+    printEfficiencySpread(tileGang, tileLane, gangSize);
+
+    writePPMImage(output.data(), width, height, "mandelbrot-profile.ppm", maxIterations);
+    writePPMHeatmap(heatmap.data(), width, height, "mandelbrot-lane-efficiency.ppm");
+    return 0;
+}
+
+// 估计迭代次数的低分辨率预扫描的采样间隔
+// Sample spacing of the low-resolution cost estimate.
+static const int ESTIMATE_STEP = 4;
+
+// Samples along an image side of size pixels: enough that the last
+// pixel still has a sample on its far side (see mandelbrot_ispc_estimate).
+static int estimateGridSize(int size, int step)
+{
+    return (size + step - 1) / step + 1;
+}
+
+//
+// buildCostOrder --
+//
+// Order all pixels by expected iteration count, from the estimate grid
+// of mandelbrot_ispc_estimate: each pixel's estimate is the bilinear
+// interpolation of the four samples around it.  A counting sort keeps
+// pixels with equal estimates in scan order, so gangs of the reordered
+// kernels get pixels that are both similar in cost and mostly nearby.
+void buildCostOrder(const int* estimate, int width, int height, int step, int maxIterations,
+                    std::vector<int64_t>& order)
+{
+    int gridWidth = estimateGridSize(width, step);
+    size_t numPixels = (size_t)width * height;
+    std::vector<int> bucket(numPixels);
+    std::vector<int64_t> start(maxIterations + 2, 0);
+
+    for (int j = 0; j < height; j++) {
+        int gj = j / step;
+        float fy = (float)(j - gj * step) / step;
+        for (int i = 0; i < width; i++) {
+            int gi = i / step;
+            float fx = (float)(i - gi * step) / step;
+            const int* e = estimate + (size_t)gj * gridWidth + gi;
+            float top = e[0] + fx * (e[1] - e[0]);
+            float bottom = e[gridWidth] + fx * (e[gridWidth + 1] - e[gridWidth]);
+            int b = std::min(maxIterations, std::max(0, (int)(top + fy * (bottom - top) + 0.5f)));
+            bucket[(size_t)j * width + i] = b;
+            start[b + 1]++;
+        }
+    }
+
+    for (int b = 0; b <= maxIterations; b++)
+        start[b + 1] += start[b];
+    order.resize(numPixels);
+    for (size_t p = 0; p < numPixels; p++)
+        order[start[bucket[p]]++] = (int64_t)p;
+}
+
+//
+// runReorderBench --
+//
+// For views 1 and 2: time the plain single-core ISPC kernel against
+// the cost-sorted order (including the estimate pre-pass and sort), and
+// against lane refilling in scan order and in cost order.  Every output
+// is checked against the serial render.  Returns the process exit status.
+int runReorderBench(int width, int height, int maxIterations, int repeat)
+{
+    size_t numPixels = (size_t)width * height;
+    std::vector<int> gold(numPixels), output(numPixels);
+    std::vector<int> estimate((size_t)estimateGridSize(width, ESTIMATE_STEP) *
+                              estimateGridSize(height, ESTIMATE_STEP));
+    std::vector<int64_t> scanOrder(numPixels), costOrder;
+    for (size_t p = 0; p < numPixels; p++)
+        scanOrder[p] = (int64_t)p;
+
+    for (int view = 1; view <= 2; view++) {
+        float x0 = -2, x1 = 1, y0 = -1, y1 = 1;
+        if (view == 2)
+            scaleAndShift(x0, x1, y0, y1, .015f, -.986f, .30f);
+        mandelbrotSerial(x0, y0, x1, y1, width, height, 0, height, maxIterations, gold.data());
+
+        double minPlain = 1e30, minOrder = 1e30, minSorted = 1e30, minRefill = 1e30, minBoth = 1e30;
+        for (int r = 0; r < repeat; ++r) {
+            double t0 = CycleTimer::currentSeconds();
+            mandelbrot_ispc(x0, y0, x1, y1, width, height, maxIterations, output.data());
+            double t1 = CycleTimer::currentSeconds();
+            minPlain = std::min(minPlain, t1 - t0);
+        }
+        if (! verifyResult (gold.data(), output.data(), width, height)) {
+            printf ("Error : ISPC output differs from sequential output\n");
+            return 1;
+        }
+
+        struct Variant {
+            const char* name;
+            bool refill;
+            const std::vector<int64_t>* order;
+            double* minTime;
+        } variants[] = {
+            { "cost-sorted",          false, &costOrder, &minSorted },
+            { "refill",               true,  &scanOrder, &minRefill },
+            { "cost-sorted + refill", true,  &costOrder, &minBoth },
+        };
+
+        for (int r = 0; r < repeat; ++r) {
+            double t0 = CycleTimer::currentSeconds();
+            mandelbrot_ispc_estimate(x0, y0, x1, y1, width, height, ESTIMATE_STEP, maxIterations,
+                                     estimate.data());
+            buildCostOrder(estimate.data(), width, height, ESTIMATE_STEP, maxIterations, costOrder);
+            minOrder = std::min(minOrder, CycleTimer::currentSeconds() - t0);
+        }
+
+        printf("[view %d plain ispc]:\t\t[%.3f] ms\n", view, minPlain * 1000);
+        printf("[view %d pre-pass + sort]:\t[%.3f] ms\n", view, minOrder * 1000);
+        for (Variant& v : variants) {
+            for (int r = 0; r < repeat; ++r) {
+                std::fill(output.begin(), output.end(), 0);
+                double t0 = CycleTimer::currentSeconds();
+                if (v.refill)
+                    mandelbrot_ispc_refill(x0, y0, x1, y1, width, height, maxIterations,
+                                           v.order->data(), 0, numPixels, output.data());
+                else
+                    mandelbrot_ispc_reordered(x0, y0, x1, y1, width, height, maxIterations,
+                                              v.order->data(), 0, numPixels, output.data());
+                *v.minTime = std::min(*v.minTime, CycleTimer::currentSeconds() - t0);
+            }
+            if (! verifyResult (gold.data(), output.data(), width, height)) {
+                printf ("Error : %s ISPC output differs from sequential output\n", v.name);
+                return 1;
+            }
+            double total = *v.minTime + (v.order == &costOrder ? minOrder : 0.0);
+            printf("[view %d %s]:\t[%.3f] ms\t(%.2fx over plain ISPC, %.2fx with pre-pass)\n",
+                   view, v.name, *v.minTime * 1000,
+                   minPlain / *v.minTime, minPlain / total);
+        }
+    }
+    return 0;
+}
+
+// 动画每一帧的缩放比例，以及每次批量提交的帧数
+// Zoom per frame of the --batch animation, and frames per batched launch.
+static const float ANIMATION_ZOOM = 0.9f;
+static const int ANIMATION_BATCH = 8;
+
+//
+// runBatchAnimation --
+//
+// Zoom into the center of the viewport over numFrames frames, first
+// calling mandelbrot_ispc_withtasks once per frame, then
+// mandelbrot_ispc_batch_withtasks once per ANIMATION_BATCH frames with
+// the same tasks per frame, and report frames/s for both.  Batched
+// frames are checked against the per-frame ones.  Returns the process
+// exit status.
+int runBatchAnimation(float x0, float y0, float x1, float y1, int width, int height,
+                      int maxIterations, int tasksPerCore, int numFrames)
+{
+    size_t numPixels = (size_t)width * height;
+    int numTasks = taskCount(tasksPerCore, height);
+
+    std::vector<float> viewports(4 * (size_t)numFrames);
+    float cx = 0.5f * (x0 + x1), cy = 0.5f * (y0 + y1);
+    float halfWidth = 0.5f * (x1 - x0), halfHeight = 0.5f * (y1 - y0);
+    for (int f = 0; f < numFrames; f++) {
+        viewports[4 * f] = cx - halfWidth;
+        viewports[4 * f + 1] = cy - halfHeight;
+        viewports[4 * f + 2] = cx + halfWidth;
+        viewports[4 * f + 3] = cy + halfHeight;
+        halfWidth *= ANIMATION_ZOOM;
+        halfHeight *= ANIMATION_ZOOM;
+    }
+
+    int batchSize = std::min(ANIMATION_BATCH, numFrames);
+    std::vector<int> single(numPixels);
+    std::vector<std::vector<int>> frames(batchSize, std::vector<int>(numPixels));
+    std::vector<int*> outputs(batchSize);
+    for (int f = 0; f < batchSize; f++)
+        outputs[f] = frames[f].data();
+
+    double singleTime = 0.0, batchTime = 0.0;
+    for (int first = 0; first < numFrames; first += batchSize) {
+        int count = std::min(batchSize, numFrames - first);
+        const float* v = &viewports[4 * (size_t)first];
+
+        double startTime = CycleTimer::currentSeconds();
+        mandelbrot_ispc_batch_withtasks(count, v, width, height, maxIterations, numTasks,
+                                        outputs.data());
+        batchTime += CycleTimer::currentSeconds() - startTime;
+
+        for (int f = 0; f < count; f++) {
+            startTime = CycleTimer::currentSeconds();
+            mandelbrot_ispc_withtasks(v[4 * f], v[4 * f + 1], v[4 * f + 2], v[4 * f + 3],
+                                      width, height, maxIterations, numTasks, single.data());
+            singleTime += CycleTimer::currentSeconds() - startTime;
+
+            if (! verifyResult (single.data(), outputs[f], width, height)) {
+                printf ("Error : Batched frame %d differs from the per-frame render\n", first + f);
+                return 1;
+            }
+        }
+    }
+
+    printf("[per-frame task ispc]:\t\t[%.3f] ms per frame (%.1f frames/s)\n",
+           singleTime * 1000 / numFrames, numFrames / singleTime);
+    printf("[batched task ispc]:\t\t[%.3f] ms per frame (%.1f frames/s, %d frames per launch)\n",
+           batchTime * 1000 / numFrames, numFrames / batchTime, batchSize);
+    printf("\t\t\t\t(%.2fx speedup from batching, %d tasks per frame)\n",
+           singleTime / batchTime, numTasks);
+    writePPMImage(outputs[(numFrames - 1) % batchSize], width, height, "mandelbrot-batch.ppm",
+                  maxIterations);
+    return 0;
+}
+
 int main(int argc, char** argv) {
 
     // 图宽，图长，每个像素点的最大迭代次数
-    const unsigned int width = 1200;
-    const unsigned int height = 800;
-    const int maxIterations = 256;
+    int width = 1200;
+    int height = 800;
+    int maxIterations = 256;
+
+    // 每个版本运行的次数，取最短时间
+    int repeat = 3;
+
+    // --center / --scale 指定的视口
+    bool centerSet = false;
+    float centerX = 0.f, centerY = 0.f;
+    double viewScale = 0.0;
+    const char* centerArg = NULL;
+
+    // 是否使用 perturbation 深度缩放引擎
+    bool deep = false;
+
+    // 流式输出时每个 band 的行数，0 表示不使用
+    int streamRows = 0;
+
+    // 渐进式多分辨率渲染
+    bool progressive = false;
+
+    // --pan 动画的帧数，0 表示不使用
+    int panFrames = 0;
+
+    // 强制使用的 ISPC target，NULL 表示运行时按 CPUID 选择
+    const char* forcedTarget = NULL;
+
+    // 运行带计数的 ISPC 内核，统计 SIMD lane 利用率
+    bool laneProfile = false;
+
+    // 比较像素重排和 lane 补位
+    bool reorder = false;
+
+    // 批量渲染动画的帧数，0 表示不使用
+    int batchFrames = 0;
 
     // 和 Prog1 一样的初始化动作
     float x0 = -2;
@@ -85,21 +864,66 @@ int main(int argc, char** argv) {
     // 一个 flag，决定是否使用 ISPC 实现
     bool useTasks = false;
 
+    // 任务版本每个核心的任务数，以及是否扫描不同的任务数
+    int tasksPerCore = 8;
+    bool taskSweep = false;
+
+    // 若指定了 tile 大小，额外运行按 tile 划分任务的版本
+    int tileWidth = 0;
+    int tileHeight = 0;
+    bool tiledLayout = false;
+
+    // 是否额外运行 Mariani-Silver 矩形细分版本
+    bool mariani = false;
+
+    // 是否额外运行 cardioid/bulb 判定 + 周期检测的提前退出版本
+    bool earlyOut = false;
+
     // 解析命令行选项
     // parse commandline options ////////////////////////////////////////////
     int opt;
     static struct option long_options[] = {
         {"tasks", 0, 0, 't'},
         {"view",  1, 0, 'v'},
+        {"tasks-per-core", 1, 0, 'k'},
+        {"task-sweep", 0, 0, 'K'},
+        {"tile",  1, 0, 'T'},
+        {"tiled-layout", 0, 0, 'L'},
+        {"early-out", 0, 0, 'e'},
+        {"mariani", 0, 0, 'm'},
+        {"width", 1, 0, 'W'},
+        {"height", 1, 0, 'H'},
+        {"iters", 1, 0, 'i'},
+        {"center", 1, 0, 'c'},
+        {"scale", 1, 0, 'z'},
+        {"repeat", 1, 0, 'r'},
+        {"deep", 0, 0, 'D'},
+        {"stream", 1, 0, 'S'},
+        {"progressive", 0, 0, 'P'},
+        {"pan", 1, 0, 'n'},
+        {"isa", 1, 0, 'I'},
+        {"lane-profile", 0, 0, 'u'},
+        {"reorder", 0, 0, 'o'},
+        {"batch", 1, 0, 'a'},
         {"help",  0, 0, '?'},
         {0 ,0, 0, 0}
     };
-    while ((opt = getopt_long(argc, argv, "tv:?", long_options, NULL)) != EOF) {
+    while ((opt = getopt_long(argc, argv, "tk:Kv:T:LemW:H:i:c:z:r:DS:Pn:I:uoa:?", long_options, NULL)) != EOF) {
 
         switch (opt) {
         case 't':
             useTasks = true;
             break;
+        case 'k':
+            tasksPerCore = atoi(optarg);
+            if (tasksPerCore <= 0) {
+                fprintf(stderr, "Invalid tasks per core %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'K':
+            taskSweep = true;
+            break;
         case 'v':
         {
             int viewIndex = atoi(optarg);
@@ -115,6 +939,101 @@ int main(int argc, char** argv) {
             }
             break;
         }
+        case 'T':
+            if (sscanf(optarg, "%dx%d", &tileWidth, &tileHeight) != 2 ||
+                tileWidth <= 0 || tileHeight <= 0) {
+                fprintf(stderr, "Invalid tile size %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'L':
+            tiledLayout = true;
+            break;
+        case 'e':
+            earlyOut = true;
+            break;
+        case 'm':
+            mariani = true;
+            break;
+        case 'W':
+        case 'H':
+        {
+            int size = atoi(optarg);
+            if (size <= 0) {
+                fprintf(stderr, "Invalid image %s %s\n", opt == 'W' ? "width" : "height", optarg);
+                return 1;
+            }
+            if (opt == 'W')
+                width = size;
+            else
+                height = size;
+            break;
+        }
+        case 'i':
+            maxIterations = atoi(optarg);
+            if (maxIterations <= 0) {
+                fprintf(stderr, "Invalid iteration count %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c':
+            if (sscanf(optarg, "%f,%f", &centerX, &centerY) != 2) {
+                fprintf(stderr, "Invalid center %s\n", optarg);
+                return 1;
+            }
+            centerSet = true;
+            centerArg = optarg;
+            break;
+        case 'z':
+            viewScale = atof(optarg);
+            if (!(viewScale > 0.0)) {
+                fprintf(stderr, "Invalid scale %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'r':
+            repeat = atoi(optarg);
+            if (repeat <= 0) {
+                fprintf(stderr, "Invalid repeat count %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'D':
+            deep = true;
+            break;
+        case 'P':
+            progressive = true;
+            break;
+        case 'a':
+            batchFrames = atoi(optarg);
+            if (batchFrames <= 0) {
+                fprintf(stderr, "Invalid frame count %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'o':
+            reorder = true;
+            break;
+        case 'u':
+            laneProfile = true;
+            break;
+        case 'I':
+            forcedTarget = optarg;
+            break;
+        case 'n':
+            panFrames = atoi(optarg);
+            if (panFrames <= 0) {
+                fprintf(stderr, "Invalid frame count %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'S':
+            streamRows = atoi(optarg);
+            if (streamRows <= 0) {
+                fprintf(stderr, "Invalid band height %s\n", optarg);
+                return 1;
+            }
+            break;
         case '?':
         default:
             usage(argv[0]);
@@ -123,20 +1042,80 @@ int main(int argc, char** argv) {
     }
     // end parsing of commandline options
 
+    if (forcedTarget) {
+        int status = forceIspcTarget(forcedTarget, argv);
+        if (status != 0)
+            return status;
+    }
+    printf("ISPC target: %s%s\n", activeIspcTarget(), forcedTarget ? " (forced)" : "");
+
+    // --center 和 --scale 覆盖 --view，缺省的一项取自当前视口
+    if (centerSet || viewScale > 0.0) {
+        if (!centerSet) {
+            centerX = 0.5f * (x0 + x1);
+            centerY = 0.5f * (y0 + y1);
+        }
+        if (viewScale <= 0.0)
+            viewScale = y1 - y0;
+        setViewport(x0, x1, y0, y1, centerX, centerY, viewScale, width, height);
+    }
+
+    if (tiledLayout && tileWidth == 0) {
+        fprintf(stderr, "--tiled-layout requires --tile\n");
+        return 1;
+    }
+
+    if (progressive)
+        return runProgressive(x0, y0, x1, y1, width, height, maxIterations);
+
+    if (batchFrames > 0)
+        return runBatchAnimation(x0, y0, x1, y1, width, height, maxIterations, tasksPerCore,
+                                 batchFrames);
+
+    if (reorder)
+        return runReorderBench(width, height, maxIterations, repeat);
+
+    if (laneProfile)
+        return runLaneProfile(x0, y0, x1, y1, width, height, maxIterations);
+
+    if (panFrames > 0)
+        return runPanAnimation(x0, y0, x1, y1, width, height, maxIterations, panFrames);
+
+    if (streamRows > 0)
+        return streamImage(x0, y0, x1, y1, width, height, maxIterations, streamRows);
+
+    if (deep) {
+        DoubleDouble centerReal = ddFromDouble(0.5 * ((double)x0 + x1));
+        DoubleDouble centerImag = ddFromDouble(0.5 * ((double)y0 + y1));
+        if (centerArg) {
+            const char* rest = ddParse(centerArg, &centerReal);
+            if (rest == NULL || *rest != ',' || ddParse(rest + 1, &centerImag) == NULL) {
+                fprintf(stderr, "Invalid center %s\n", centerArg);
+                return 1;
+            }
+        }
+        return renderDeepZoom(centerReal, centerImag, viewScale > 0.0 ? viewScale : y1 - y0,
+                              width, height, maxIterations, useTasks, repeat);
+    }
+
     // 初始化结果数组
-    int *output_serial = new int[width*height];
-    int *output_ispc = new int[width*height];
-    int *output_ispc_tasks = new int[width*height];
-    for (unsigned int i = 0; i < width * height; ++i)
+    size_t numPixels = (size_t)width * height;
+    int *output_serial = new int[numPixels];
+    int *output_ispc = new int[numPixels];
+    int *output_ispc_tasks = new int[numPixels];
+    for (size_t i = 0; i < numPixels; ++i)
         output_serial[i] = 0;
 
+    printf("Rendering %dx%d, %d iterations, view [%g, %g] x [%g, %g]\n",
+           width, height, maxIterations, x0, x1, y0, y1);
+
     // 运行三次串行版本，统计运行时长，并且收集串行版本跑出来的结果
     //
     // Run the serial implementation. Teport the minimum time of three
     // runs for robust timing.
     //
     double minSerial = 1e30;
-    for (int i = 0; i < 3; ++i) {
+    for (int i = 0; i < repeat; ++i) {
         double startTime = CycleTimer::currentSeconds();
         mandelbrotSerial(x0, y0, x1, y1, width, height, 0, height, maxIterations, output_serial);
         double endTime = CycleTimer::currentSeconds();
@@ -148,7 +1127,7 @@ int main(int argc, char** argv) {
 
     // 重置 output_ispc
     // Clear out the buffer
-    for (unsigned int i = 0; i < width * height; ++i)
+    for (size_t i = 0; i < numPixels; ++i)
         output_ispc[i] = 0;
 
     // 运行 mandelbrot_ispc 三次，收集运行时长和结果
@@ -156,7 +1135,7 @@ int main(int argc, char** argv) {
     // Compute the image using the ispc implementation
     //
     double minISPC = 1e30;
-    for (int i = 0; i < 3; ++i) {
+    for (int i = 0; i < repeat; ++i) {
         double startTime = CycleTimer::currentSeconds();
         mandelbrot_ispc(x0, y0, x1, y1, width, height, maxIterations, output_ispc);
         double endTime = CycleTimer::currentSeconds();
@@ -179,7 +1158,7 @@ int main(int argc, char** argv) {
 
     // 重置 output_ispc_tasks
     // Clear out the buffer
-    for (unsigned int i = 0; i < width * height; ++i) {
+    for (size_t i = 0; i < numPixels; ++i) {
         output_ispc_tasks[i] = 0;
     }
 
@@ -189,14 +1168,16 @@ int main(int argc, char** argv) {
         //
         // Tasking version of the ISPC code
         //
-        for (int i = 0; i < 3; ++i) {
+        int numTasks = taskCount(tasksPerCore, height);
+        for (int i = 0; i < repeat; ++i) {
             double startTime = CycleTimer::currentSeconds();
-            mandelbrot_ispc_withtasks(x0, y0, x1, y1, width, height, maxIterations, output_ispc_tasks);
+            mandelbrot_ispc_withtasks(x0, y0, x1, y1, width, height, maxIterations, numTasks,
+                                      output_ispc_tasks);
             double endTime = CycleTimer::currentSeconds();
             minTaskISPC = std::min(minTaskISPC, endTime - startTime);
         }
 
-        printf("[mandelbrot multicore ispc]:\t[%.3f] ms\n", minTaskISPC * 1000);
+        printf("[mandelbrot multicore ispc]:\t[%.3f] ms (%d tasks)\n", minTaskISPC * 1000, numTasks);
         writePPMImage(output_ispc_tasks, width, height, "mandelbrot-task-ispc.ppm", maxIterations);
 
         if (! verifyResult (output_serial, output_ispc_tasks, width, height)) {
@@ -205,10 +1186,160 @@ int main(int argc, char** argv) {
         }
     }
 
+    // 若 --task-sweep 选项存在，扫描任务数
+    if (taskSweep && !sweepTaskCounts(x0, y0, x1, y1, width, height, maxIterations, repeat,
+                                      output_serial, minSerial))
+        return 1;
+
+    // 若 --tile 选项存在，运行按二维 tile 划分任务的版本
+    double minTileISPC = 1e30;
+    if (tileWidth > 0) {
+        //
+        // Tiled tasking version: one task per tileWidth x tileHeight tile
+        //
+        for (size_t i = 0; i < numPixels; ++i) {
+            output_ispc_tasks[i] = 0;
+        }
+
+        for (int i = 0; i < repeat; ++i) {
+            double startTime = CycleTimer::currentSeconds();
+            mandelbrot_ispc_withtiles(x0, y0, x1, y1, width, height, tileWidth, tileHeight,
+                                      tiledLayout, maxIterations, output_ispc_tasks);
+            double endTime = CycleTimer::currentSeconds();
+            minTileISPC = std::min(minTileISPC, endTime - startTime);
+        }
+
+        printf("[mandelbrot tiled ispc]:\t[%.3f] ms (%dx%d tiles%s)\n",
+               minTileISPC * 1000, tileWidth, tileHeight, tiledLayout ? " stored tiled" : "");
+
+        int* output_linear = output_ispc_tasks;
+        if (tiledLayout) {
+            TileLayout layout = { width, height, tileWidth, tileHeight };
+            output_linear = new int[numPixels];
+            detileImage(layout, output_ispc_tasks, output_linear);
+            writePPMImageTiled(output_ispc_tasks, width, height, tileWidth, tileHeight,
+                               "mandelbrot-tile-ispc.ppm", maxIterations);
+        } else {
+            writePPMImage(output_ispc_tasks, width, height, "mandelbrot-tile-ispc.ppm", maxIterations);
+        }
+
+        bool tilesCorrect = verifyResult (output_serial, output_linear, width, height);
+        if (output_linear != output_ispc_tasks)
+            delete[] output_linear;
+        if (! tilesCorrect) {
+            printf ("Error : ISPC output differs from sequential output\n");
+            return 1;
+        }
+    }
+
+    // 若 --mariani 选项存在，运行 Mariani-Silver 版本并与暴力计算的结果对比
+    double minMarianiSerial = 1e30;
+    double minMarianiISPC = 1e30;
+    double minMarianiTaskISPC = 1e30;
+    if (mariani) {
+        for (int i = 0; i < repeat; ++i) {
+            double startTime = CycleTimer::currentSeconds();
+            mandelbrotSerialMariani(x0, y0, x1, y1, width, height, 0, height, maxIterations, output_ispc);
+            double endTime = CycleTimer::currentSeconds();
+            minMarianiSerial = std::min(minMarianiSerial, endTime - startTime);
+        }
+        printf("[mandelbrot serial mariani]:\t[%.3f] ms\n", minMarianiSerial * 1000);
+        if (! verifyResult (output_serial, output_ispc, width, height)) {
+            printf ("Error : Mariani-Silver output differs from sequential output\n");
+            return 1;
+        }
+
+        for (int i = 0; i < repeat; ++i) {
+            double startTime = CycleTimer::currentSeconds();
+            mandelbrot_ispc_mariani(x0, y0, x1, y1, width, height, maxIterations, output_ispc);
+            double endTime = CycleTimer::currentSeconds();
+            minMarianiISPC = std::min(minMarianiISPC, endTime - startTime);
+        }
+        printf("[mandelbrot ispc mariani]:\t[%.3f] ms\n", minMarianiISPC * 1000);
+        if (! verifyResult (output_serial, output_ispc, width, height)) {
+            printf ("Error : ISPC Mariani-Silver output differs from sequential output\n");
+            return 1;
+        }
+
+        if (useTasks) {
+            for (int i = 0; i < repeat; ++i) {
+                double startTime = CycleTimer::currentSeconds();
+                mandelbrot_ispc_mariani_withtasks(x0, y0, x1, y1, width, height, maxIterations, output_ispc_tasks);
+                double endTime = CycleTimer::currentSeconds();
+                minMarianiTaskISPC = std::min(minMarianiTaskISPC, endTime - startTime);
+            }
+            printf("[mandelbrot multicore ispc mariani]:\t[%.3f] ms\n", minMarianiTaskISPC * 1000);
+            if (! verifyResult (output_serial, output_ispc_tasks, width, height)) {
+                printf ("Error : ISPC Mariani-Silver output differs from sequential output\n");
+                return 1;
+            }
+        }
+    }
+
+    // 若 --early-out 选项存在，运行提前退出版本并与暴力计算的结果对比
+    double minEarlySerial = 1e30;
+    double minEarlyISPC = 1e30;
+    double minEarlyTaskISPC = 1e30;
+    if (earlyOut) {
+        for (int i = 0; i < repeat; ++i) {
+            double startTime = CycleTimer::currentSeconds();
+            mandelbrotSerialEarlyOut(x0, y0, x1, y1, width, height, 0, height, maxIterations, output_ispc);
+            double endTime = CycleTimer::currentSeconds();
+            minEarlySerial = std::min(minEarlySerial, endTime - startTime);
+        }
+        printf("[mandelbrot serial early-out]:\t[%.3f] ms\n", minEarlySerial * 1000);
+        if (! verifyResult (output_serial, output_ispc, width, height)) {
+            printf ("Error : early-out output differs from sequential output\n");
+            return 1;
+        }
+
+        for (int i = 0; i < repeat; ++i) {
+            double startTime = CycleTimer::currentSeconds();
+            mandelbrot_ispc_earlyout(x0, y0, x1, y1, width, height, maxIterations, output_ispc);
+            double endTime = CycleTimer::currentSeconds();
+            minEarlyISPC = std::min(minEarlyISPC, endTime - startTime);
+        }
+        printf("[mandelbrot ispc early-out]:\t[%.3f] ms\n", minEarlyISPC * 1000);
+        if (! verifyResult (output_serial, output_ispc, width, height)) {
+            printf ("Error : ISPC early-out output differs from sequential output\n");
+            return 1;
+        }
+
+        if (useTasks) {
+            for (int i = 0; i < repeat; ++i) {
+                double startTime = CycleTimer::currentSeconds();
+                mandelbrot_ispc_earlyout_withtasks(x0, y0, x1, y1, width, height, maxIterations, output_ispc_tasks);
+                double endTime = CycleTimer::currentSeconds();
+                minEarlyTaskISPC = std::min(minEarlyTaskISPC, endTime - startTime);
+            }
+            printf("[mandelbrot multicore ispc early-out]:\t[%.3f] ms\n", minEarlyTaskISPC * 1000);
+            if (! verifyResult (output_serial, output_ispc_tasks, width, height)) {
+                printf ("Error : ISPC early-out output differs from sequential output\n");
+                return 1;
+            }
+        }
+    }
+
     printf("\t\t\t\t(%.2fx speedup from ISPC)\n", minSerial/minISPC);
     if (useTasks) {
         printf("\t\t\t\t(%.2fx speedup from task ISPC)\n", minSerial/minTaskISPC);
     }
+    if (tileWidth > 0) {
+        printf("\t\t\t\t(%.2fx speedup from tiled task ISPC)\n", minSerial/minTileISPC);
+    }
+    if (mariani) {
+        printf("\t\t\t\t(%.2fx speedup from serial Mariani-Silver)\n", minSerial/minMarianiSerial);
+        printf("\t\t\t\t(%.2fx speedup from ISPC Mariani-Silver)\n", minSerial/minMarianiISPC);
+        if (useTasks)
+            printf("\t\t\t\t(%.2fx speedup from task ISPC Mariani-Silver)\n", minSerial/minMarianiTaskISPC);
+    }
+
+    if (earlyOut) {
+        printf("\t\t\t\t(%.2fx speedup from serial early-out)\n", minSerial/minEarlySerial);
+        printf("\t\t\t\t(%.2fx speedup from ISPC early-out)\n", minSerial/minEarlyISPC);
+        if (useTasks)
+            printf("\t\t\t\t(%.2fx speedup from task ISPC early-out)\n", minSerial/minEarlyTaskISPC);
+    }
 
     delete[] output_serial;
     delete[] output_ispc;
@@ -37,6 +37,11 @@
    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <math.h>
+
+#include "deepZoom.h"
+#include "progressive.h"
+#include <stddef.h>
 
 static inline int mandel(float c_re, float c_im, int count)
 {
@@ -56,6 +61,66 @@ static inline int mandel(float c_re, float c_im, int count)
     return i;
 }
 
+// Points this far inside the main cardioid or the period-2 bulb (in
+// units of c) are reported as members without iterating.  The margin
+// keeps the analytic test away from the boundary, where the float
+// orbit of a member can still escape.
+static const double EARLY_OUT_MARGIN = 1e-3;
+
+static inline bool inCardioidOrBulb(float c_re, float c_im)
+{
+    double x = c_re, y = c_im;
+
+    double xq = x - 0.25;
+    double p = sqrt(xq * xq + y * y);
+    if (x < p - 2.0 * p * p + 0.25 - EARLY_OUT_MARGIN)
+        return true;
+
+    double r = 0.25 - EARLY_OUT_MARGIN;
+    return (x + 1.0) * (x + 1.0) + y * y < r * r;
+}
+
+//
+// mandelEarlyOut --
+//
+// Same result as mandel(), with two shortcuts for points in the set.
+// Points well inside the main cardioid or period-2 bulb return count
+// immediately.  Otherwise the orbit is compared against a saved point
+// that is refreshed at iterations 1, 2, 4, 8, ... (Brent's cycle
+// detection).  An exact repeat of a float state means the float
+// iteration has entered a cycle and can never escape, so the result is
+// count without running the remaining iterations.
+static inline int mandelEarlyOut(float c_re, float c_im, int count)
+{
+    if (inCardioidOrBulb(c_re, c_im))
+        return count;
+
+    float z_re = c_re, z_im = c_im;
+    float saved_re = z_re, saved_im = z_im;
+    int checkpoint = 1;
+    int i;
+    for (i = 0; i < count; ++i) {
+
+        if (z_re * z_re + z_im * z_im > 4.f)
+            break;
+
+        float new_re = z_re*z_re - z_im*z_im;
+        float new_im = 2.f * z_re * z_im;
+        z_re = c_re + new_re;
+        z_im = c_im + new_im;
+
+        if (z_re == saved_re && z_im == saved_im)
+            return count;
+        if (i + 1 == checkpoint) {
+            saved_re = z_re;
+            saved_im = z_im;
+            checkpoint *= 2;
+        }
+    }
+
+    return i;
+}
+
 //
 // MandelbrotSerial --
 //
@@ -84,9 +149,274 @@ void mandelbrotSerial(
             float x = x0 + i * dx;
             float y = y0 + j * dy;
 
-            int index = (j * width + i);
+            size_t index = ((size_t)j * width + i);
             output[index] = mandel(x, y, maxIterations);
         }
     }
 }
 
+//
+// MandelbrotSerialEarlyOut --
+//
+// mandelbrotSerial using mandelEarlyOut() for every pixel.  Produces the
+// same image as mandelbrotSerial.
+void mandelbrotSerialEarlyOut(
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int startRow, int totalRows,
+    int maxIterations,
+    int output[])
+{
+    float dx = (x1 - x0) / width;
+    float dy = (y1 - y0) / height;
+
+    int endRow = startRow + totalRows;
+
+    for (int j = startRow; j < endRow; j++) {
+        for (int i = 0; i < width; ++i) {
+            float x = x0 + i * dx;
+            float y = y0 + j * dy;
+
+            size_t index = ((size_t)j * width + i);
+            output[index] = mandelEarlyOut(x, y, maxIterations);
+        }
+    }
+}
+//
+// MandelbrotSerialPass --
+//
+// Compute the pixels of the progressive pass with the given step (see
+// common/progressive.h) in rows [startRow, startRow + totalRows), and
+// paint each over its step x step block.  Pixel values are exactly
+// those of mandelbrotSerial.
+void mandelbrotSerialPass(
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int startRow, int totalRows,
+    int step,
+    int maxIterations,
+    int output[])
+{
+    float dx = (x1 - x0) / width;
+    float dy = (y1 - y0) / height;
+
+    int endRow = startRow + totalRows;
+
+    for (int j = startRow; j < endRow; j++) {
+        if (j % step != 0)
+            continue;
+        int first, stride;
+        progressivePassColumns(j, step, &first, &stride);
+        for (int i = first; i < width; i += stride) {
+            float x = x0 + i * dx;
+            float y = y0 + j * dy;
+
+            fillProgressiveBlock(output, width, height, i, j, step, mandel(x, y, maxIterations));
+        }
+    }
+}
+
+//
+// MandelbrotSerialDouble --
+//
+// mandelbrotSerial iterating in double instead of float.  Resolves views
+// down to a scale of about 1e-13; used to check the perturbation
+// renderer at zooms where both are valid.
+void mandelbrotSerialDouble(
+    double x0, double y0, double x1, double y1,
+    int width, int height,
+    int startRow, int totalRows,
+    int maxIterations,
+    int output[])
+{
+    double dx = (x1 - x0) / width;
+    double dy = (y1 - y0) / height;
+
+    int endRow = startRow + totalRows;
+
+    for (int j = startRow; j < endRow; j++) {
+        for (int i = 0; i < width; ++i) {
+            double c_re = x0 + i * dx;
+            double c_im = y0 + j * dy;
+            double z_re = c_re, z_im = c_im;
+            int k;
+            for (k = 0; k < maxIterations; ++k) {
+                if (z_re * z_re + z_im * z_im > 4.0)
+                    break;
+                double new_re = z_re*z_re - z_im*z_im;
+                double new_im = 2.0 * z_re * z_im;
+                z_re = c_re + new_re;
+                z_im = c_im + new_im;
+            }
+
+            output[(size_t)j * width + i] = k;
+        }
+    }
+}
+
+//
+// MandelbrotSerialDeep --
+//
+// Render a deep-zoom frame (common/deepZoom.h) one pixel at a time with
+// deepPixel().  Reference output for the threaded and ISPC versions.
+void mandelbrotSerialDeep(
+    const DeepFrame& frame,
+    int maxIterations,
+    int output[])
+{
+    for (int j = 0; j < frame.height; j++) {
+        for (int i = 0; i < frame.width; ++i) {
+            double dc_re = frame.deltaX0 + i * frame.pixelSize;
+            double dc_im = frame.deltaY0 + j * frame.pixelSize;
+
+            output[(size_t)j * frame.width + i] = deepPixel(frame, dc_re, dc_im, maxIterations);
+        }
+    }
+}
+
+
+//
+// Mariani-Silver rectangle subdivision --
+//
+// A rectangle whose border pixels all share one iteration count is
+// filled with that count without iterating its interior; otherwise it
+// is split in two along its longer side and each half is examined the
+// same way.  Rectangles at or below MARIANI_MIN_AREA interior pixels are
+// computed pixel by pixel.  Every evaluated pixel uses the same mapping
+// as mandelbrotSerial, so evaluated pixels match it bit for bit.
+
+static const int MARIANI_MIN_AREA = 256;
+
+typedef struct {
+    float x0, y0;
+    float dx, dy;
+    int maxIterations;
+    int* out;       // pixel (originX, originY) of the region
+    int stride;     // elements between consecutive rows of out
+    int originX, originY;
+} MarianiRegion;
+
+static inline int& marianiAt(const MarianiRegion& r, int i, int j)
+{
+    return r.out[(size_t)(j - r.originY) * r.stride + (i - r.originX)];
+}
+
+static inline void marianiCompute(const MarianiRegion& r, int i, int j)
+{
+    float x = r.x0 + i * r.dx;
+    float y = r.y0 + j * r.dy;
+    marianiAt(r, i, j) = mandel(x, y, r.maxIterations);
+}
+
+// Border pixels (inclusive) of [left, right] x [top, bottom] are already
+// computed; fill in the interior.
+static void marianiInterior(const MarianiRegion& r, int left, int top, int right, int bottom)
+{
+    if (right - left < 2 || bottom - top < 2)
+        return;
+
+    // Small rectangles are not worth the risk of a wrong fill.
+    if ((long long)(right - left - 1) * (bottom - top - 1) <= MARIANI_MIN_AREA) {
+        for (int j = top + 1; j < bottom; j++)
+            for (int i = left + 1; i < right; i++)
+                marianiCompute(r, i, j);
+        return;
+    }
+
+    int value = marianiAt(r, left, top);
+    bool uniform = true;
+    for (int i = left; i <= right && uniform; i++)
+        uniform = marianiAt(r, i, top) == value && marianiAt(r, i, bottom) == value;
+    for (int j = top; j <= bottom && uniform; j++)
+        uniform = marianiAt(r, left, j) == value && marianiAt(r, right, j) == value;
+
+    // Compute the line that splits the rectangle along its longer side.
+    // A uniform border alone is not trusted: the split line must agree
+    // as well, which catches escaping filaments thinner than a pixel
+    // that cross the interior without touching the border.
+    bool vertical = right - left >= bottom - top;
+    int mid = vertical ? (left + right) / 2 : (top + bottom) / 2;
+    if (vertical) {
+        for (int j = top + 1; j < bottom; j++) {
+            marianiCompute(r, mid, j);
+            uniform = uniform && marianiAt(r, mid, j) == value;
+        }
+    } else {
+        for (int i = left + 1; i < right; i++) {
+            marianiCompute(r, i, mid);
+            uniform = uniform && marianiAt(r, i, mid) == value;
+        }
+    }
+
+    if (uniform) {
+        for (int j = top + 1; j < bottom; j++)
+            for (int i = left + 1; i < right; i++)
+                marianiAt(r, i, j) = value;
+        return;
+    }
+
+    if (vertical) {
+        marianiInterior(r, left, top, mid, bottom);
+        marianiInterior(r, mid, top, right, bottom);
+    } else {
+        marianiInterior(r, left, top, right, mid);
+        marianiInterior(r, left, mid, right, bottom);
+    }
+}
+
+//
+// mandelbrotRectMariani --
+//
+// Compute the rectX, rectY, rectW x rectH rectangle of the image with
+// Mariani-Silver subdivision.  out points at pixel (rectX, rectY) and
+// consecutive rows of the rectangle are stride elements apart, so the
+// rectangle can live inside the full image or in a packed tile.
+void mandelbrotRectMariani(
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int rectX, int rectY, int rectW, int rectH,
+    int maxIterations,
+    int out[], int stride)
+{
+    MarianiRegion r;
+    r.x0 = x0;
+    r.y0 = y0;
+    r.dx = (x1 - x0) / width;
+    r.dy = (y1 - y0) / height;
+    r.maxIterations = maxIterations;
+    r.out = out;
+    r.stride = stride;
+    r.originX = rectX;
+    r.originY = rectY;
+
+    int right = rectX + rectW - 1;
+    int bottom = rectY + rectH - 1;
+    for (int i = rectX; i <= right; i++) {
+        marianiCompute(r, i, rectY);
+        marianiCompute(r, i, bottom);
+    }
+    for (int j = rectY + 1; j < bottom; j++) {
+        marianiCompute(r, rectX, j);
+        marianiCompute(r, right, j);
+    }
+    marianiInterior(r, rectX, rectY, right, bottom);
+}
+
+//
+// MandelbrotSerialMariani --
+//
+// Same interface as mandelbrotSerial, using Mariani-Silver subdivision
+// on the block of rows [startRow, startRow + totalRows).
+void mandelbrotSerialMariani(
+    float x0, float y0, float x1, float y1,
+    int width, int height,
+    int startRow, int totalRows,
+    int maxIterations,
+    int output[])
+{
+    if (width <= 0 || totalRows <= 0)
+        return;
+    mandelbrotRectMariani(x0, y0, x1, y1, width, height,
+                          0, startRow, width, totalRows,
+                          maxIterations, output + (size_t)startRow * width, width);
+}
@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <algorithm>
+#include <getopt.h>
 
 #include "CycleTimer.h"
+#include "ispcTarget.h"
 #include "saxpy_ispc.h"
 
 extern void saxpySerial(int N, float a, float* X, float* Y, float* result);
@@ -29,7 +31,42 @@ static void verifyResult(int N, float* result, float* gold) {
 using namespace ispc;
 
 
-int main() {
+static void usage(const char* progname) {
+    printf("Usage: %s [options]\n", progname);
+    printf("Program Options:\n");
+    printf("  -I  --isa <TARGET> Run the ISPC code built for TARGET (needs 'make targets'):\n");
+    printf("                     sse4-i32x4, avx2-i32x8, avx2-i32x16 or avx512skx-i32x16\n");
+    printf("  -?  --help         This message\n");
+}
+
+int main(int argc, char** argv) {
+
+    const char* forcedTarget = NULL;
+
+    int opt;
+    static struct option long_options[] = {
+        {"isa", 1, 0, 'I'},
+        {"help", 0, 0, '?'},
+        {0 ,0, 0, 0}
+    };
+    while ((opt = getopt_long(argc, argv, "I:?", long_options, NULL)) != EOF) {
+        switch (opt) {
+        case 'I':
+            forcedTarget = optarg;
+            break;
+        case '?':
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (forcedTarget) {
+        int status = forceIspcTarget(forcedTarget, argv);
+        if (status != 0)
+            return status;
+    }
+    printf("ISPC target: %s%s\n", activeIspcTarget(), forcedTarget ? " (forced)" : "");
 
     const unsigned int N = 20 * 1000 * 1000; // 20 M element vectors (~80 MB)
     const unsigned int TOTAL_BYTES = 4 * N * sizeof(float);